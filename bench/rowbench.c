@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../src/board.h"
+
+// The Tile based slideLeft the game used before the packed engine, kept as a baseline.
+typedef struct {
+	int value;
+	int xsrc, ysrc;
+	float tspawn, tslide;
+} Tile;
+
+static void slideLeft(Tile board[BOARD_SIZE][BOARD_SIZE]) {
+	for (int y = 0; y < BOARD_SIZE; y++) {
+		int left = 0;
+		for (int x = 0; x < BOARD_SIZE; x++) {
+			if (board[y][x].value == 0) continue;
+			board[y][left].value = board[y][x].value;
+			board[y][left].xsrc = x;
+			left++;
+		}
+		for (int x = left; x < BOARD_SIZE; x++) {
+			board[y][x].value = 0;
+		}
+		for (int x = 0; x < left - 1; x++) {
+			if (board[y][x].value == board[y][x + 1].value) {
+				board[y][x].value++;
+				board[y][x + 1].value = 0;
+				board[y][x].xsrc = board[y][x + 1].xsrc;
+				x++;
+			}
+		}
+		int final = 0;
+		for (int x = 0; x < left; x++) {
+			if (board[y][x].value == 0) continue;
+			board[y][final].value = board[y][x].value;
+			board[y][final].xsrc = board[y][x].xsrc;
+			final++;
+		}
+		for (int x = final; x < BOARD_SIZE; x++) {
+			board[y][x].value = 0;
+		}
+	}
+}
+
+#define COUNT (1 << 16)
+#define ROUNDS 64
+
+int main(void) {
+
+	boardInit();
+
+	static Board boards[COUNT];
+	static Tile tiles[BOARD_SIZE][BOARD_SIZE];
+	srand(2048);
+	for (int i = 0; i < COUNT; i++) {
+		Board board = 0;
+		for (int cell = 0; cell < BOARD_CELLS; cell++) {
+			if (rand() % 4 != 0) {
+				board |= (Board)(1 + rand() % 11) << (4 * cell);
+			}
+		}
+		boards[i] = board;
+	}
+
+	unsigned long long checksum = 0;
+	clock_t start = clock();
+	for (int round = 0; round < ROUNDS; round++) {
+		for (int i = 0; i < COUNT; i++) {
+			// Includes filling the tiles, as the old game copied the board before every slide.
+			for (int y = 0; y < BOARD_SIZE; y++) {
+				for (int x = 0; x < BOARD_SIZE; x++) {
+					tiles[y][x].value = boardGet(boards[i], x, y);
+					tiles[y][x].xsrc = x;
+					tiles[y][x].ysrc = y;
+				}
+			}
+			slideLeft(tiles);
+			checksum += tiles[0][0].value + tiles[BOARD_SIZE - 1][0].value;
+		}
+	}
+	double tileSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (int round = 0; round < ROUNDS; round++) {
+		for (int i = 0; i < COUNT; i++) {
+			Board result = boardMove(boards[i], DIR_LEFT, NULL);
+			checksum += boardGet(result, 0, 0) + boardGet(result, 0, BOARD_SIZE - 1);
+		}
+	}
+	double tableSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	double moves = (double)COUNT * ROUNDS;
+	printf("Tile slideLeft:  %8.2f Mmoves/s\n", moves / tileSeconds * 1e-6);
+	printf("Row table left:  %8.2f Mmoves/s\n", moves / tableSeconds * 1e-6);
+	printf("Speedup:         %8.2fx (checksum %llu)\n", tileSeconds / tableSeconds, checksum);
+
+	return 0;
+}
@@ -0,0 +1,389 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+
+#include "ai.h"
+#include "clock.h"
+#include "ntuple.h"
+#include "sched.h"
+#include "simd.h"
+#include "ttable.h"
+#include "zobrist.h"
+
+#define LOST_PENALTY 200000.0f
+#define MONOTONICITY_POWER 4.0f
+#define MONOTONICITY_WEIGHT 47.0f
+#define SUM_POWER 3.5f
+#define SUM_WEIGHT 11.0f
+#define MERGES_WEIGHT 700.0f
+#define EMPTY_WEIGHT 270.0f
+
+#define SPAWN_FOUR (1.0f / BOARD_FOUR_ODDS)
+#define SPAWN_TWO (1.0f - SPAWN_FOUR)
+
+// Chance branches less likely than this are cut off and evaluated directly.
+#define PROBABILITY_CUTOFF 0.0001f
+
+// Shared between every thread calling aiBestMove().
+#define CACHE_BITS 20
+
+static float rowHeuristic[65536];
+static TransTable *cache;
+static NTuple network;
+
+static float evaluateRow(uint16_t row) {
+	int cells[4];
+	for (int i = 0; i < 4; i++) {
+		cells[i] = (row >> (4 * i)) & 0xF;
+	}
+	float sum = 0.0f;
+	int empty = 0;
+	int merges = 0;
+	int previous = 0;
+	int counter = 0;
+	for (int i = 0; i < 4; i++) {
+		int value = cells[i];
+		sum += powf(value, SUM_POWER);
+		if (value == 0) {
+			empty++;
+			continue;
+		}
+		if (previous == value) {
+			counter++;
+		} else if (counter > 0) {
+			merges += 1 + counter;
+			counter = 0;
+		}
+		previous = value;
+	}
+	if (counter > 0) merges += 1 + counter;
+
+	float monotonicityLeft = 0.0f;
+	float monotonicityRight = 0.0f;
+	for (int i = 1; i < 4; i++) {
+		float a = powf(cells[i - 1], MONOTONICITY_POWER);
+		float b = powf(cells[i], MONOTONICITY_POWER);
+		if (cells[i - 1] > cells[i]) {
+			monotonicityLeft += a - b;
+		} else {
+			monotonicityRight += b - a;
+		}
+	}
+
+	return LOST_PENALTY
+		+ EMPTY_WEIGHT * empty
+		+ MERGES_WEIGHT * merges
+		- MONOTONICITY_WEIGHT * fminf(monotonicityLeft, monotonicityRight)
+		- SUM_WEIGHT * sum;
+}
+
+void aiInit(void) {
+	for (uint32_t row = 0; row < 65536; row++) {
+		rowHeuristic[row] = evaluateRow((uint16_t)row);
+	}
+	if (!cache) cache = ttCreate(CACHE_BITS);
+	simdLevel();
+}
+
+static float evaluateRows(Board board) {
+	return rowHeuristic[(uint16_t)board]
+		+ rowHeuristic[(uint16_t)(board >> 16)]
+		+ rowHeuristic[(uint16_t)(board >> 32)]
+		+ rowHeuristic[(uint16_t)(board >> 48)];
+}
+
+bool aiLoadWeights(const char *path) {
+	if (network.weights) ntupleDestroy(&network);
+	return ntupleMap(&network, path, true);
+}
+
+// The network estimates the score still to come after an afterstate, so a move
+// is worth its merges plus that. The heuristic scores positions, not moves.
+static inline float moveReward(int gained) {
+	return network.weights ? (float)gained : 0.0f;
+}
+
+float aiEvaluate(Board board) {
+	if (network.weights) return ntupleEvaluate(&network, board);
+	return evaluateRows(board) + evaluateRows(boardTranspose(board));
+}
+
+#ifdef SIMD_X86
+// Sums the four row lookups of four boards, in the scalar summation order.
+SIMD_AVX2_TARGET static inline __m128 gatherRows4(__m256i b) {
+	__m256i low16 = _mm256_set1_epi64x(0xFFFF);
+	__m128 sum = _mm256_i64gather_ps(rowHeuristic, _mm256_and_si256(b, low16), 4);
+	sum = _mm_add_ps(sum, _mm256_i64gather_ps(rowHeuristic, _mm256_and_si256(_mm256_srli_epi64(b, 16), low16), 4));
+	sum = _mm_add_ps(sum, _mm256_i64gather_ps(rowHeuristic, _mm256_and_si256(_mm256_srli_epi64(b, 32), low16), 4));
+	return _mm_add_ps(sum, _mm256_i64gather_ps(rowHeuristic, _mm256_srli_epi64(b, 48), 4));
+}
+
+SIMD_AVX2_TARGET static int evaluateAvx2(const Board *boards, int count, float *values) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256i board = _mm256_loadu_si256((const __m256i *)(boards + i));
+		_mm_storeu_ps(values + i, _mm_add_ps(gatherRows4(board), gatherRows4(simdTranspose4(board))));
+	}
+	return i;
+}
+
+SIMD_AVX512_TARGET static inline __m256 gatherRows8(__m512i b) {
+	__m512i low16 = _mm512_set1_epi64(0xFFFF);
+	__m256 sum = _mm512_i64gather_ps(_mm512_and_si512(b, low16), rowHeuristic, 4);
+	sum = _mm256_add_ps(sum, _mm512_i64gather_ps(_mm512_and_si512(_mm512_srli_epi64(b, 16), low16), rowHeuristic, 4));
+	sum = _mm256_add_ps(sum, _mm512_i64gather_ps(_mm512_and_si512(_mm512_srli_epi64(b, 32), low16), rowHeuristic, 4));
+	return _mm256_add_ps(sum, _mm512_i64gather_ps(_mm512_srli_epi64(b, 48), rowHeuristic, 4));
+}
+
+SIMD_AVX512_TARGET static int evaluateAvx512(const Board *boards, int count, float *values) {
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m512i board = _mm512_loadu_si512((const void *)(boards + i));
+		_mm256_storeu_ps(values + i, _mm256_add_ps(gatherRows8(board), gatherRows8(simdTranspose8(board))));
+	}
+	return i;
+}
+#endif
+
+void aiEvaluateBatch(const Board *boards, int count, float *values) {
+	if (network.weights) {
+		ntupleEvaluateBatch(&network, boards, count, values);
+		return;
+	}
+	int done = 0;
+#ifdef SIMD_X86
+	switch (simdLevel()) {
+		case SIMD_AVX512: done = evaluateAvx512(boards, count, values); // fall through
+		case SIMD_AVX2:   done += evaluateAvx2(boards + done, count - done, values + done); break;
+		case SIMD_SCALAR: break;
+	}
+#endif
+	for (int i = done; i < count; i++) {
+		values[i] = aiEvaluate(boards[i]);
+	}
+}
+
+// Per-thread search state. A timed search sets the shared stop flag when its
+// deadline passes; values computed after that are discarded, never cached.
+typedef struct {
+	atomic_bool *stop;
+	double deadline;
+	unsigned nodes;
+	bool aborted;
+} Search;
+
+static bool searchStopped(Search *search) {
+	if (!search->stop) return false;
+	if (search->aborted) return true;
+	if ((++search->nodes & 1023) == 0 && clockNow() > search->deadline) {
+		atomic_store_explicit(search->stop, true, memory_order_relaxed);
+	}
+	search->aborted = atomic_load_explicit(search->stop, memory_order_relaxed);
+	return search->aborted;
+}
+
+// Whether searchSpawn() searches a position rather than evaluating it, and so
+// needs its hashes.
+static inline bool spawnSearched(float probability, int depth) {
+	return depth > 0 && probability >= PROBABILITY_CUTOFF;
+}
+
+static float searchMove(Search *search, Board board, const ZobristImages *hashes, float probability, int depth);
+
+static float searchSpawn(Search *search, Board board, const ZobristImages *hashes, float probability, int depth) {
+	if (!spawnSearched(probability, depth)) {
+		return aiEvaluate(board);
+	}
+	if (searchStopped(search)) return 0.0f;
+	// Evaluation is symmetric, so all 8 images of a position share one entry.
+	Board key = boardCanonical(board);
+	uint64_t hash = zobristCanonical(hashes);
+	float cached;
+	if (cache && ttProbe(cache, key, hash, depth, probability, &cached)) {
+		return cached;
+	}
+	uint16_t empty = boardEmptyMask(board);
+	int count = __builtin_popcount(empty);
+	float cellProbability = probability / count;
+
+	// Children whose moves all end in leaves are expanded here and their
+	// afterstates scored in one batch, the rest are searched recursively.
+	Board leaves[BOARD_CELLS * 2 * 4];
+	float leafReward[BOARD_CELLS * 2 * 4];
+	uint8_t leafChild[BOARD_CELLS * 2 * 4];
+	float childValue[BOARD_CELLS * 2];
+	float childWeight[BOARD_CELLS * 2];
+	int children = 0;
+	int leafCount = 0;
+	while (empty) {
+		int cell = __builtin_ctz(empty);
+		empty &= empty - 1;
+		for (int value = 1; value <= 2; value++) {
+			Board child = board | ((Board)value << (4 * cell));
+			float weight = value == 1 ? SPAWN_TWO : SPAWN_FOUR;
+			float childProbability = cellProbability * weight;
+			childWeight[children] = weight;
+			childValue[children] = 0.0f;
+			if (depth > 1 && childProbability >= PROBABILITY_CUTOFF) {
+				ZobristImages childHashes = zobristImagesUpdate(*hashes, board, child);
+				childValue[children] = searchMove(search, child, &childHashes, childProbability, depth);
+			} else {
+				int mask = boardMoveMask(child);
+				if (mask) childValue[children] = -INFINITY;
+				for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+					if (!(mask & (1 << dir))) continue;
+					int gained = 0;
+					leaves[leafCount] = boardMove(child, (Direction)dir, &gained);
+					leafReward[leafCount] = moveReward(gained);
+					leafChild[leafCount] = (uint8_t)children;
+					leafCount++;
+				}
+			}
+			children++;
+		}
+	}
+	if (leafCount > 0) {
+		float values[BOARD_CELLS * 2 * 4];
+		aiEvaluateBatch(leaves, leafCount, values);
+		for (int i = 0; i < leafCount; i++) {
+			float value = leafReward[i] + values[i];
+			if (value > childValue[leafChild[i]]) childValue[leafChild[i]] = value;
+		}
+	}
+	float total = 0.0f;
+	for (int i = 0; i < children; i++) {
+		total += childWeight[i] * childValue[i];
+	}
+	total /= count;
+	if (cache && !search->aborted) ttStore(cache, key, hash, depth, probability, total);
+	return total;
+}
+
+// A position with no move left is worth nothing.
+static float searchMove(Search *search, Board board, const ZobristImages *hashes, float probability, int depth) {
+	int mask = boardMoveMask(board);
+	if (!mask) return 0.0f;
+	bool searched = spawnSearched(probability, depth - 1);
+	float best = -INFINITY;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int gained = 0;
+		Board moved = boardMove(board, (Direction)dir, &gained);
+		ZobristImages movedHashes;
+		if (searched) movedHashes = zobristImagesUpdate(*hashes, board, moved);
+		float value = moveReward(gained) + searchSpawn(search, moved, searched ? &movedHashes : NULL, probability, depth - 1);
+		if (value > best) best = value;
+	}
+	return best;
+}
+
+Direction aiBestMove(Board board, int depth) {
+	if (cache) ttNewSearch(cache);
+	Search search = { 0 };
+	ZobristImages hashes = zobristImages(board);
+	int mask = boardMoveMask(board);
+	Direction best = mask ? (Direction)__builtin_ctz(mask) : DIR_LEFT;
+	float bestValue = -INFINITY;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int gained = 0;
+		Board moved = boardMove(board, (Direction)dir, &gained);
+		ZobristImages movedHashes = zobristImagesUpdate(hashes, board, moved);
+		float value = moveReward(gained) + searchSpawn(&search, moved, &movedHashes, 1.0f, depth - 1);
+		if (value > bestValue) {
+			bestValue = value;
+			best = (Direction)dir;
+		}
+	}
+	return best;
+}
+
+// One task per root move and spawn outcome, so the chance nodes below the
+// root are split across threads as well as the moves.
+typedef struct {
+	Board child;
+	ZobristImages hashes;
+	float weight;
+	int dir;
+	float value;
+} RootTask;
+
+typedef struct {
+	RootTask *tasks;
+	Search *searches;
+	int depth;
+} RootSearch;
+
+static void runRootTask(void *context, int task, int worker) {
+	RootSearch *root = context;
+	RootTask *rootTask = &root->tasks[task];
+	rootTask->value = searchMove(&root->searches[worker], rootTask->child, &rootTask->hashes, rootTask->weight, root->depth - 1);
+}
+
+Direction aiBestMoveTimed(Board board, int threads, double seconds, int *depthReached) {
+	if (threads <= 0) threads = schedCores();
+	if (cache) ttNewSearch(cache);
+
+	RootTask tasks[4 * BOARD_CELLS * 2];
+	ZobristImages hashes = zobristImages(board);
+	float rewards[4] = { 0.0f };
+	int count = 0;
+	int mask = boardMoveMask(board);
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int gained = 0;
+		Board moved = boardMove(board, (Direction)dir, &gained);
+		rewards[dir] = moveReward(gained);
+		ZobristImages movedHashes = zobristImagesUpdate(hashes, board, moved);
+		uint16_t empty = boardEmptyMask(moved);
+		float cellWeight = 1.0f / __builtin_popcount(empty);
+		while (empty) {
+			int cell = __builtin_ctz(empty);
+			empty &= empty - 1;
+			for (int value = 1; value <= 2; value++) {
+				Board child = moved | ((Board)value << (4 * cell));
+				float weight = cellWeight * (value == 1 ? SPAWN_TWO : SPAWN_FOUR);
+				tasks[count++] = (RootTask){ child, zobristImagesUpdate(movedHashes, moved, child), weight, dir, 0.0f };
+			}
+		}
+	}
+
+	atomic_bool stop;
+	atomic_init(&stop, false);
+	Search *searches = calloc(threads, sizeof(Search));
+	double deadline = clockNow() + seconds;
+
+	Direction best = aiBestMove(board, 1);
+	int reached = 1;
+	for (int depth = 2; depth <= AI_MAX_DEPTH; depth++) {
+		for (int i = 0; i < threads; i++) {
+			searches[i] = (Search){ &stop, deadline, 0, false };
+		}
+		RootSearch root = { tasks, searches, depth };
+		schedRun(count, threads, runRootTask, &root);
+		if (atomic_load(&stop)) break;
+
+		float values[4];
+		for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+			values[dir] = rewards[dir];
+		}
+		for (int i = 0; i < count; i++) {
+			values[tasks[i].dir] += tasks[i].weight * tasks[i].value;
+		}
+		float bestValue = -INFINITY;
+		for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+			if (!(mask & (1 << dir)) || values[dir] <= bestValue) continue;
+			bestValue = values[dir];
+			best = (Direction)dir;
+		}
+		reached = depth;
+		if (clockNow() > deadline) break;
+	}
+
+	free(searches);
+	if (depthReached) *depthReached = reached;
+	return best;
+}
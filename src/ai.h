@@ -0,0 +1,32 @@
+#ifndef AI_H
+#define AI_H
+
+#include <stdbool.h>
+
+#include "board.h"
+
+#define AI_DEFAULT_DEPTH 3
+#define AI_MAX_DEPTH 12
+
+// Builds the heuristic tables, call once after boardInit().
+void aiInit(void);
+
+// Scores positions with a trained n-tuple network instead of the hand heuristic.
+// Call at startup, before any search.
+bool aiLoadWeights(const char *path);
+
+// Heuristic value of a position, higher is better.
+float aiEvaluate(Board board);
+
+// aiEvaluate() for count boards at once, vectorized where the CPU allows.
+void aiEvaluateBatch(const Board *boards, int count, float *values);
+
+// Best move by expectimax over tile spawns, searching depth moves ahead.
+// The board must have at least one legal move. Safe to call from several threads.
+Direction aiBestMove(Board board, int depth);
+
+// Iterative deepening on `threads` threads (<= 0 for every core), returning the move of
+// the deepest search that finished within `seconds`. Depth 1 always completes.
+Direction aiBestMoveTimed(Board board, int threads, double seconds, int *depthReached);
+
+#endif
@@ -0,0 +1,57 @@
+#include "anim.h"
+
+static void settleCell(Anim *anim, int cell) {
+	anim->src[cell] = (int8_t)cell;
+	anim->tslide[cell] = 1.0;
+	anim->tspawn[cell] = 1.0;
+}
+
+void animInit(Anim *anim) {
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		settleCell(anim, cell);
+	}
+	anim->active = 0;
+}
+
+// Cells that are not active already have both timers at 1.
+void animSettle(Anim *anim) {
+	for (uint32_t active = anim->active; active != 0; active &= active - 1) {
+		settleCell(anim, __builtin_ctz(active));
+	}
+	anim->active = 0;
+}
+
+void animSlide(Anim *anim, Board board, Direction dir) {
+	int src[BOARD_CELLS];
+	boardTrace(board, dir, src);
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		if (src[cell] < 0) continue;
+		anim->src[cell] = (int8_t)src[cell];
+		anim->tslide[cell] = 0.0;
+		anim->active |= 1u << cell;
+	}
+}
+
+void animSpawn(Anim *anim, int cell) {
+	anim->src[cell] = (int8_t)cell;
+	anim->tslide[cell] = 1.0;
+	anim->tspawn[cell] = 0.0;
+	anim->active |= 1u << cell;
+}
+
+void animStep(Anim *anim, float slideStep, float spawnStep) {
+	if (anim->active == 0) return;
+	// Stepping every cell keeps the loops branch-free and vectorizable, and
+	// settled timers stay clamped at 1.
+	uint32_t active = 0;
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		float tslide = anim->tslide[cell] + slideStep;
+		float tspawn = anim->tspawn[cell] + spawnStep;
+		anim->tslide[cell] = tslide < 1.0f ? tslide : 1.0f;
+		anim->tspawn[cell] = tspawn < 1.0f ? tspawn : 1.0f;
+	}
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		active |= (uint32_t)(anim->tslide[cell] < 1.0f || anim->tspawn[cell] < 1.0f) << cell;
+	}
+	anim->active = active;
+}
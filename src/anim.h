@@ -0,0 +1,37 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board.h"
+
+// Tile animations, kept apart from the board as one array per field so a
+// frame advances all timers in a single pass. Indexed by destination cell.
+typedef struct {
+	int8_t src[BOARD_CELLS];     // cell the tile slides from
+	float tslide[BOARD_CELLS];   // slide progress, 0 to 1
+	float tspawn[BOARD_CELLS];   // spawn zoom progress, 0 to 1
+	uint32_t active;             // bit i is set while cell i has a timer below 1
+} Anim;
+
+// No animations, each tile resting on its own cell.
+void animInit(Anim *anim);
+
+// Finishes the running animations.
+void animSettle(Anim *anim);
+
+// Starts the slide of every tile for a move of board in dir, before the move is made.
+void animSlide(Anim *anim, Board board, Direction dir);
+
+// Starts the zoom of a tile spawned in cell.
+void animSpawn(Anim *anim, int cell);
+
+// Advances slide timers by slideStep and spawn timers by spawnStep.
+void animStep(Anim *anim, float slideStep, float spawnStep);
+
+static inline bool animSettled(const Anim *anim) {
+	return anim->active == 0;
+}
+
+#endif
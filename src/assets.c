@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "assets.h"
+
+#define FONT_PATH "assets/font.ttf"
+#define FONT_SIZE 128
+#define FONT_GLYPHS 95
+#define FONT_PADDING 4
+#define MUSIC_PATH "assets/music.mp3"
+#define SOUNDS 5
+
+static const char *soundPaths[SOUNDS] = {
+	"assets/pop.wav",
+	"assets/stuck.wav",
+	"assets/win.wav",
+	"assets/lose.wav",
+	"assets/restart.wav",
+};
+
+// Everything the worker decodes, handed over once done is set.
+struct AssetJob {
+	pthread_t thread;
+	bool threaded;
+	atomic_bool done;
+	Wave waves[SOUNDS];
+	unsigned char *musicData;
+	int musicSize;
+	GlyphInfo *glyphs;
+	Rectangle *recs;
+	Image atlas;
+};
+
+static void *decode(void *arg) {
+	AssetJob *job = arg;
+	// Same glyphs and atlas as LoadFontEx(FONT_PATH, FONT_SIZE, NULL, 0), minus the texture upload.
+	int fontSize = 0;
+	unsigned char *fontData = LoadFileData(FONT_PATH, &fontSize);
+	if (fontData) {
+		job->glyphs = LoadFontData(fontData, fontSize, FONT_SIZE, NULL, 0, FONT_DEFAULT);
+		if (job->glyphs) {
+			job->atlas = GenImageFontAtlas(job->glyphs, &job->recs, FONT_GLYPHS, FONT_SIZE, FONT_PADDING, 0);
+		}
+		UnloadFileData(fontData);
+	}
+	for (int i = 0; i < SOUNDS; i++) {
+		job->waves[i] = LoadWave(soundPaths[i]);
+	}
+	// Music stays compressed and is decoded while it streams.
+	job->musicData = LoadFileData(MUSIC_PATH, &job->musicSize);
+	atomic_store_explicit(&job->done, true, memory_order_release);
+	return NULL;
+}
+
+void assetsLoad(Assets *assets) {
+	*assets = (Assets){ 0 };
+	AssetJob *job = calloc(1, sizeof(AssetJob));
+	if (!job) return;
+	atomic_init(&job->done, false);
+	job->threaded = pthread_create(&job->thread, NULL, decode, job) == 0;
+	// No thread to spare, decode right here instead.
+	if (!job->threaded) decode(job);
+	assets->job = job;
+}
+
+static void finish(Assets *assets) {
+	AssetJob *job = assets->job;
+	if (job->threaded) pthread_join(job->thread, NULL);
+	Sound *sounds[SOUNDS] = {
+		&assets->slideSound,
+		&assets->stuckSound,
+		&assets->winSound,
+		&assets->loseSound,
+		&assets->restartSound,
+	};
+	for (int i = 0; i < SOUNDS; i++) {
+		if (!IsWaveValid(job->waves[i])) continue;
+		*sounds[i] = LoadSoundFromWave(job->waves[i]);
+		UnloadWave(job->waves[i]);
+	}
+	if (job->musicData) {
+		assets->musicData = job->musicData;
+		assets->music = LoadMusicStreamFromMemory(".mp3", job->musicData, job->musicSize);
+	}
+	if (job->recs) {
+		assets->font = (Font){
+			.baseSize = FONT_SIZE,
+			.glyphCount = FONT_GLYPHS,
+			.glyphPadding = FONT_PADDING,
+			.texture = LoadTextureFromImage(job->atlas),
+			.recs = job->recs,
+			.glyphs = job->glyphs,
+		};
+		UnloadImage(job->atlas);
+	} else if (job->glyphs) {
+		UnloadFontData(job->glyphs, FONT_GLYPHS);
+	}
+	free(job);
+	assets->job = NULL;
+}
+
+bool assetsPoll(Assets *assets) {
+	if (!assets->job || !atomic_load_explicit(&assets->job->done, memory_order_acquire)) return false;
+	finish(assets);
+	return true;
+}
+
+void assetsUnload(Assets *assets) {
+	if (assets->job) finish(assets);
+	if (IsMusicValid(assets->music)) UnloadMusicStream(assets->music);
+	UnloadFileData(assets->musicData);
+	if (IsFontValid(assets->font)) UnloadFont(assets->font);
+	Sound sounds[SOUNDS] = { assets->slideSound, assets->stuckSound, assets->winSound, assets->loseSound, assets->restartSound };
+	for (int i = 0; i < SOUNDS; i++) {
+		if (IsSoundValid(sounds[i])) UnloadSound(sounds[i]);
+	}
+	*assets = (Assets){ 0 };
+}
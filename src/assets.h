@@ -0,0 +1,35 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdbool.h>
+#include <raylib.h>
+
+typedef struct AssetJob AssetJob;
+
+// Font and sounds of the game. Until they are ready the font is whatever the
+// caller put there, and sounds and music are unloaded, which raylib plays as
+// silence.
+typedef struct {
+	Font font;
+	Sound slideSound;
+	Sound stuckSound;
+	Sound winSound;
+	Sound loseSound;
+	Sound restartSound;
+	Music music;
+	unsigned char *musicData;
+	AssetJob *job;
+} Assets;
+
+// Starts reading and decoding the sounds and rasterizing the font on a worker
+// thread. Needs no window or audio device, so it can run before both exist.
+void assetsLoad(Assets *assets);
+
+// Call on the main thread every frame. Once the worker is done, uploads the
+// font to the GPU and the sounds to the audio device and returns true, once.
+bool assetsPoll(Assets *assets);
+
+// Waits for a running load and frees everything.
+void assetsUnload(Assets *assets);
+
+#endif
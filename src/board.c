@@ -0,0 +1,127 @@
+#include "board.h"
+#include "rowtable.h"
+#include "zobrist.h"
+
+Board boardTranspose(Board board) {
+	Board a1 = board & 0xF0F00F0FF0F00F0FULL;
+	Board a2 = board & 0x0000F0F00000F0F0ULL;
+	Board a3 = board & 0x0F0F00000F0F0000ULL;
+	Board a = a1 | (a2 << 12) | (a3 >> 12);
+	Board b1 = a & 0xFF00FF0000FF00FFULL;
+	Board b2 = a & 0x00FF00FF00000000ULL;
+	Board b3 = a & 0x00000000FF00FF00ULL;
+	return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+Board boardMirror(Board board) {
+	board = ((board & 0xF0F0F0F0F0F0F0F0ULL) >> 4) | ((board & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	return ((board & 0xFF00FF00FF00FF00ULL) >> 8) | ((board & 0x00FF00FF00FF00FFULL) << 8);
+}
+
+Board boardFlip(Board board) {
+	return (board >> 48) | ((board >> 16) & 0xFFFF0000ULL) | ((board << 16) & 0xFFFF00000000ULL) | (board << 48);
+}
+
+static Board minBoard(Board a, Board b) {
+	return a < b ? a : b;
+}
+
+Board boardCanonical(Board board) {
+	Board transposed = boardTranspose(board);
+	Board flipped = boardFlip(board);
+	Board transposedFlipped = boardFlip(transposed);
+	Board best = minBoard(board, boardMirror(board));
+	best = minBoard(best, minBoard(flipped, boardMirror(flipped)));
+	best = minBoard(best, minBoard(transposed, boardMirror(transposed)));
+	return minBoard(best, minBoard(transposedFlipped, boardMirror(transposedFlipped)));
+}
+
+void boardInit(void) {
+	rowTableInit();
+	zobristInit();
+}
+
+static Board slideRows(Board board, const RowSlide table[65536], int *score) {
+	Board result = 0;
+	for (int y = 0; y < BOARD_SIZE; y++) {
+		const RowSlide *slide = &table[(uint16_t)(board >> (16 * y))];
+		result |= (Board)slide->row << (16 * y);
+		*score += slide->score;
+	}
+	return result;
+}
+
+Board boardMove(Board board, Direction dir, int *score) {
+	int gained = 0;
+	Board result = board;
+	switch (dir) {
+		case DIR_LEFT:  result = slideRows(board, rowSlideLeft, &gained); break;
+		case DIR_RIGHT: result = slideRows(board, rowSlideRight, &gained); break;
+		case DIR_UP:    result = boardTranspose(slideRows(boardTranspose(board), rowSlideLeft, &gained)); break;
+		case DIR_DOWN:  result = boardTranspose(slideRows(boardTranspose(board), rowSlideRight, &gained)); break;
+	}
+	if (score) *score += gained;
+	return result;
+}
+
+int boardMoveMask(Board board) {
+	Board transposed = boardTranspose(board);
+	int mask = 0;
+	for (int i = 0; i < BOARD_SIZE; i++) {
+		uint16_t row = (uint16_t)(board >> (16 * i));
+		uint16_t column = (uint16_t)(transposed >> (16 * i));
+		mask |= rowSlideLeft[row].moved << DIR_LEFT;
+		mask |= rowSlideRight[row].moved << DIR_RIGHT;
+		mask |= rowSlideLeft[column].moved << DIR_UP;
+		mask |= rowSlideRight[column].moved << DIR_DOWN;
+	}
+	return mask;
+}
+
+static int lineCell(Direction dir, int line, int pos) {
+	switch (dir) {
+		case DIR_LEFT:  return line * BOARD_SIZE + pos;
+		case DIR_RIGHT: return line * BOARD_SIZE + (BOARD_SIZE - 1 - pos);
+		case DIR_UP:    return pos * BOARD_SIZE + line;
+		case DIR_DOWN:  return (BOARD_SIZE - 1 - pos) * BOARD_SIZE + line;
+	}
+	return 0;
+}
+
+void boardTrace(Board board, Direction dir, int src[BOARD_CELLS]) {
+	for (int i = 0; i < BOARD_CELLS; i++) {
+		src[i] = -1;
+	}
+	for (int line = 0; line < BOARD_SIZE; line++) {
+		int values[BOARD_SIZE];
+		int cells[BOARD_SIZE];
+		int count = 0;
+		for (int pos = 0; pos < BOARD_SIZE; pos++) {
+			int cell = lineCell(dir, line, pos);
+			int value = (int)((board >> (4 * cell)) & 0xF);
+			if (value == 0) continue;
+			values[count] = value;
+			cells[count] = cell;
+			count++;
+		}
+		int pos = 0;
+		for (int i = 0; i < count; i++) {
+			int from = cells[i];
+			if (i + 1 < count && values[i + 1] == values[i] && values[i] < BOARD_MAX_TILE) {
+				from = cells[i + 1];
+				i++;
+			}
+			src[lineCell(dir, line, pos)] = from;
+			pos++;
+		}
+	}
+}
+
+int boardMaxTile(Board board) {
+	int max = 0;
+	for (int i = 0; i < BOARD_CELLS; i++) {
+		int value = (int)((board >> (4 * i)) & 0xF);
+		if (value > max) max = value;
+	}
+	return max;
+}
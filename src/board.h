@@ -0,0 +1,99 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#define BOARD_SIZE 4
+#define BOARD_CELLS (BOARD_SIZE * BOARD_SIZE)
+
+// A spawned tile is a 4 once in every BOARD_FOUR_ODDS spawns, otherwise a 2.
+#define BOARD_FOUR_ODDS 8
+
+// Largest exponent a cell can hold (32768). Two of these do not merge, since the
+// result would not fit in a nibble.
+#define BOARD_MAX_TILE 15
+
+// 16 cells packed as 4-bit exponents, cell (x, y) at bits 4 * (y * 4 + x).
+// An exponent of 0 is an empty cell, 1 is a 2-tile, 2 is a 4-tile and so on.
+typedef uint64_t Board;
+
+typedef enum {
+	DIR_LEFT,
+	DIR_RIGHT,
+	DIR_UP,
+	DIR_DOWN
+} Direction;
+
+static inline int boardGet(Board board, int x, int y) {
+	return (int)((board >> (4 * (y * BOARD_SIZE + x))) & 0xF);
+}
+
+static inline Board boardSet(Board board, int x, int y, int value) {
+	int shift = 4 * (y * BOARD_SIZE + x);
+	return (board & ~((Board)0xF << shift)) | ((Board)(value & 0xF) << shift);
+}
+
+// Bit i is set when cell i is empty.
+static inline uint16_t boardEmptyMask(Board board) {
+	Board x = board | (board >> 1);
+	x |= x >> 2;
+	x = ~x & 0x1111111111111111ULL;
+	x = (x | (x >> 3)) & 0x0303030303030303ULL;
+	x = (x | (x >> 6)) & 0x000F000F000F000FULL;
+	x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+	return (uint16_t)(x | (x >> 24));
+}
+
+static inline int boardCountEmpty(Board board) {
+	return __builtin_popcount(boardEmptyMask(board));
+}
+
+// Cell index of the index-th empty cell, counting from cell 0.
+static inline int boardEmptyCell(Board board, int index) {
+	uint32_t mask = boardEmptyMask(board);
+#ifdef __BMI2__
+	return __builtin_ctz(_pdep_u32(1u << index, mask));
+#else
+	for (int i = 0; i < index; i++) {
+		mask &= mask - 1;
+	}
+	return __builtin_ctz(mask);
+#endif
+}
+
+// Places a tile of the given exponent in the index-th empty cell, which must exist.
+static inline Board boardSpawn(Board board, int index, int value) {
+	return board | ((Board)value << (4 * boardEmptyCell(board, index)));
+}
+
+// Builds the row transition tables, call once before any move.
+void boardInit(void);
+
+Board boardTranspose(Board board);
+
+// Reverses every row (left-right mirror image).
+Board boardMirror(Board board);
+
+// Reverses the order of the rows (upside down).
+Board boardFlip(Board board);
+
+// Smallest of the 8 rotations and reflections of the board. Positions that are
+// symmetric images of each other play the same, so caches can share one entry.
+Board boardCanonical(Board board);
+
+// Slides the board, adding the value of merged tiles to score if non-null.
+Board boardMove(Board board, Direction dir, int *score);
+
+// Bit (1 << dir) is set for every direction that changes the board, 0 means game over.
+int boardMoveMask(Board board);
+
+// For every destination cell of a move, the cell index its tile slid from, or -1.
+void boardTrace(Board board, Direction dir, int src[BOARD_CELLS]);
+
+int boardMaxTile(Board board);
+
+#endif
@@ -0,0 +1,327 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "dataset.h"
+
+#define DATASET_MAGIC "2048DAT"
+
+// Columns start on this boundary so raw ones can be read in place with vector loads.
+#define COLUMN_ALIGNMENT 64
+
+// Stdio buffer, so the file grows in large sequential writes.
+#define WRITE_BUFFER (4 << 20)
+
+const uint8_t datasetColumnSize[DATASET_COLUMNS] = {
+	[DATASET_BOARD] = sizeof(Board),
+	[DATASET_NEXT] = sizeof(Board),
+	[DATASET_GAME] = sizeof(uint32_t),
+	[DATASET_MOVE_NUMBER] = sizeof(uint32_t),
+	[DATASET_REWARD] = sizeof(int32_t),
+	[DATASET_MOVE] = sizeof(uint8_t),
+};
+
+typedef struct {
+	DatasetChunk info;
+	uint8_t *columns[DATASET_COLUMNS];
+} Chunk;
+
+struct DatasetWriter {
+	FILE *file;
+	char *buffer;
+	uint64_t offset;
+	DatasetCodec codec;
+	int chunkRows;
+	bool ok;
+	uint64_t rows;
+	DatasetChunk *index;
+	uint32_t chunks, capacity;
+	uint8_t *scratch;
+	size_t scratchSize;
+	// Rows are appended to filling. In background mode the thread writes
+	// pending, and clears it once done, while the other buffer fills.
+	Chunk buffers[2];
+	Chunk *filling;
+	bool background;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	Chunk *pending;
+	bool finishing;
+};
+
+bool datasetHasZlib(void) {
+#ifdef HAVE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void resetChunk(Chunk *chunk) {
+	memset(&chunk->info, 0, sizeof(chunk->info));
+	chunk->info.minMaxTile = UINT8_MAX;
+	chunk->info.minMoveNumber = UINT32_MAX;
+	chunk->info.minGame = UINT32_MAX;
+}
+
+static bool writeBytes(DatasetWriter *writer, const void *data, size_t size) {
+	writer->ok = writer->ok && fwrite(data, 1, size, writer->file) == size;
+	writer->offset += size;
+	return writer->ok;
+}
+
+static void writeAligned(DatasetWriter *writer, const void *data, size_t size) {
+	static const uint8_t zeros[COLUMN_ALIGNMENT];
+	size_t padding = (COLUMN_ALIGNMENT - writer->offset % COLUMN_ALIGNMENT) % COLUMN_ALIGNMENT;
+	writeBytes(writer, zeros, padding);
+	writeBytes(writer, data, size);
+}
+
+// Compresses if asked and writes every column of the chunk, then records it in the index.
+static void writeChunk(DatasetWriter *writer, Chunk *chunk) {
+	if (writer->chunks == writer->capacity) {
+		uint32_t capacity = writer->capacity ? 2 * writer->capacity : 64;
+		DatasetChunk *index = realloc(writer->index, capacity * sizeof(DatasetChunk));
+		if (!index) {
+			writer->ok = false;
+			return;
+		}
+		writer->index = index;
+		writer->capacity = capacity;
+	}
+	for (int column = 0; column < DATASET_COLUMNS; column++) {
+		size_t rawSize = (size_t)chunk->info.rows * datasetColumnSize[column];
+		const void *data = chunk->columns[column];
+		size_t size = rawSize;
+#ifdef HAVE_ZLIB
+		if (writer->codec == DATASET_ZLIB) {
+			uLongf compressed = writer->scratchSize;
+			if (compress2(writer->scratch, &compressed, data, rawSize, 1) != Z_OK) writer->ok = false;
+			data = writer->scratch;
+			size = compressed;
+		}
+#endif
+		writeAligned(writer, data, size);
+		chunk->info.columns[column] = (DatasetColumnInfo){ writer->offset - size, (uint32_t)size, (uint32_t)rawSize };
+	}
+	writer->index[writer->chunks++] = chunk->info;
+	writer->rows += chunk->info.rows;
+}
+
+static void *writerRun(void *arg) {
+	DatasetWriter *writer = arg;
+	pthread_mutex_lock(&writer->lock);
+	for (;;) {
+		while (!writer->pending && !writer->finishing) {
+			pthread_cond_wait(&writer->changed, &writer->lock);
+		}
+		if (!writer->pending) break;
+		Chunk *chunk = writer->pending;
+		pthread_mutex_unlock(&writer->lock);
+		writeChunk(writer, chunk);
+		pthread_mutex_lock(&writer->lock);
+		writer->pending = NULL;
+		pthread_cond_broadcast(&writer->changed);
+	}
+	pthread_mutex_unlock(&writer->lock);
+	return NULL;
+}
+
+static void submitChunk(DatasetWriter *writer) {
+	Chunk *chunk = writer->filling;
+	if (!writer->background) {
+		writeChunk(writer, chunk);
+		resetChunk(chunk);
+		return;
+	}
+	// Waits for the thread to finish the other buffer, then swaps.
+	pthread_mutex_lock(&writer->lock);
+	while (writer->pending) {
+		pthread_cond_wait(&writer->changed, &writer->lock);
+	}
+	writer->pending = chunk;
+	pthread_cond_broadcast(&writer->changed);
+	pthread_mutex_unlock(&writer->lock);
+	writer->filling = chunk == &writer->buffers[0] ? &writer->buffers[1] : &writer->buffers[0];
+	resetChunk(writer->filling);
+}
+
+static void freeWriter(DatasetWriter *writer) {
+	for (int i = 0; i < 2; i++) {
+		for (int column = 0; column < DATASET_COLUMNS; column++) {
+			free(writer->buffers[i].columns[column]);
+		}
+	}
+	free(writer->scratch);
+	free(writer->index);
+	free(writer->buffer);
+	free(writer);
+}
+
+DatasetWriter *datasetCreate(const char *path, int chunkRows, DatasetCodec codec, bool background) {
+	if (chunkRows <= 0 || (codec == DATASET_ZLIB && !datasetHasZlib())) return NULL;
+	DatasetWriter *writer = calloc(1, sizeof(DatasetWriter));
+	if (!writer) return NULL;
+	writer->codec = codec;
+	writer->chunkRows = chunkRows;
+	writer->background = background;
+	writer->ok = true;
+	bool ok = true;
+	for (int i = 0; i < (background ? 2 : 1); i++) {
+		for (int column = 0; column < DATASET_COLUMNS; column++) {
+			writer->buffers[i].columns[column] = malloc((size_t)chunkRows * datasetColumnSize[column]);
+			ok = ok && writer->buffers[i].columns[column];
+		}
+	}
+#ifdef HAVE_ZLIB
+	if (codec == DATASET_ZLIB) {
+		writer->scratchSize = compressBound((uLong)chunkRows * sizeof(Board));
+		writer->scratch = malloc(writer->scratchSize);
+		ok = ok && writer->scratch;
+	}
+#endif
+	writer->buffer = malloc(WRITE_BUFFER);
+	writer->file = ok && writer->buffer ? fopen(path, "wb") : NULL;
+	if (!writer->file) {
+		freeWriter(writer);
+		return NULL;
+	}
+	setvbuf(writer->file, writer->buffer, _IOFBF, WRITE_BUFFER);
+	// Left zeroed until the index is written, so an unfinished file does not open.
+	DatasetHeader header = { 0 };
+	writeBytes(writer, &header, sizeof(header));
+
+	writer->filling = &writer->buffers[0];
+	resetChunk(writer->filling);
+	if (background) {
+		pthread_mutex_init(&writer->lock, NULL);
+		pthread_cond_init(&writer->changed, NULL);
+		if (pthread_create(&writer->thread, NULL, writerRun, writer) != 0) {
+			writer->background = false;
+			pthread_cond_destroy(&writer->changed);
+			pthread_mutex_destroy(&writer->lock);
+		}
+	}
+	return writer;
+}
+
+void datasetAppend(DatasetWriter *writer, const Transition *transition) {
+	Chunk *chunk = writer->filling;
+	DatasetChunk *info = &chunk->info;
+	uint32_t row = info->rows++;
+	memcpy(chunk->columns[DATASET_BOARD] + row * sizeof(Board), &transition->board, sizeof(Board));
+	memcpy(chunk->columns[DATASET_NEXT] + row * sizeof(Board), &transition->next, sizeof(Board));
+	memcpy(chunk->columns[DATASET_GAME] + row * sizeof(uint32_t), &transition->game, sizeof(uint32_t));
+	memcpy(chunk->columns[DATASET_MOVE_NUMBER] + row * sizeof(uint32_t), &transition->moveNumber, sizeof(uint32_t));
+	memcpy(chunk->columns[DATASET_REWARD] + row * sizeof(int32_t), &transition->reward, sizeof(int32_t));
+	chunk->columns[DATASET_MOVE][row] = transition->move;
+
+	uint8_t maxTile = (uint8_t)boardMaxTile(transition->board);
+	if (maxTile < info->minMaxTile) info->minMaxTile = maxTile;
+	if (maxTile > info->maxMaxTile) info->maxMaxTile = maxTile;
+	if (transition->moveNumber < info->minMoveNumber) info->minMoveNumber = transition->moveNumber;
+	if (transition->moveNumber > info->maxMoveNumber) info->maxMoveNumber = transition->moveNumber;
+	if (transition->game < info->minGame) info->minGame = transition->game;
+	if (transition->game > info->maxGame) info->maxGame = transition->game;
+
+	if (info->rows == (uint32_t)writer->chunkRows) submitChunk(writer);
+}
+
+bool datasetFinish(DatasetWriter *writer) {
+	if (writer->filling->info.rows > 0) submitChunk(writer);
+	if (writer->background) {
+		pthread_mutex_lock(&writer->lock);
+		writer->finishing = true;
+		pthread_cond_broadcast(&writer->changed);
+		pthread_mutex_unlock(&writer->lock);
+		pthread_join(writer->thread, NULL);
+		pthread_cond_destroy(&writer->changed);
+		pthread_mutex_destroy(&writer->lock);
+	}
+	static const uint8_t zeros[sizeof(uint64_t)];
+	writeBytes(writer, zeros, (sizeof(uint64_t) - writer->offset % sizeof(uint64_t)) % sizeof(uint64_t));
+	DatasetHeader header = { DATASET_MAGIC, DATASET_VERSION, writer->codec, writer->rows, writer->offset, writer->chunks, 0 };
+	writeBytes(writer, writer->index, writer->chunks * sizeof(DatasetChunk));
+	writer->ok = writer->ok && fseek(writer->file, 0, SEEK_SET) == 0;
+	writeBytes(writer, &header, sizeof(header));
+	bool ok = fclose(writer->file) == 0 && writer->ok;
+	freeWriter(writer);
+	return ok;
+}
+
+bool datasetOpen(Dataset *dataset, const char *path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DatasetHeader)) {
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t)st.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	DatasetHeader *header = &dataset->header;
+	memcpy(header, mapping, sizeof(DatasetHeader));
+	bool ok = memcmp(header->magic, DATASET_MAGIC, sizeof(header->magic)) == 0
+		&& header->version == DATASET_VERSION
+		&& (header->codec == DATASET_RAW || (header->codec == DATASET_ZLIB && datasetHasZlib()))
+		&& header->indexOffset % sizeof(uint64_t) == 0
+		&& header->indexOffset <= size
+		&& (size - header->indexOffset) / sizeof(DatasetChunk) >= header->chunks;
+	const DatasetChunk *chunks = (const DatasetChunk *)((const uint8_t *)mapping + header->indexOffset);
+	for (uint32_t i = 0; ok && i < header->chunks; i++) {
+		for (int column = 0; column < DATASET_COLUMNS; column++) {
+			const DatasetColumnInfo *info = &chunks[i].columns[column];
+			ok = ok && info->offset + info->size <= header->indexOffset
+				&& info->rawSize == (uint64_t)chunks[i].rows * datasetColumnSize[column]
+				&& (header->codec != DATASET_RAW || info->size == info->rawSize);
+		}
+	}
+	if (!ok) {
+		munmap(mapping, size);
+		return false;
+	}
+	madvise(mapping, size, MADV_SEQUENTIAL);
+	dataset->chunks = chunks;
+	dataset->data = mapping;
+	dataset->size = size;
+	return true;
+}
+
+void datasetClose(Dataset *dataset) {
+	if (dataset->data) munmap((void *)dataset->data, dataset->size);
+	dataset->data = NULL;
+}
+
+const void *datasetColumnData(const Dataset *dataset, int chunk, DatasetColumn column) {
+	if (dataset->header.codec != DATASET_RAW) return NULL;
+	return dataset->data + dataset->chunks[chunk].columns[column].offset;
+}
+
+bool datasetReadColumn(const Dataset *dataset, int chunk, DatasetColumn column, void *out) {
+	const DatasetColumnInfo *info = &dataset->chunks[chunk].columns[column];
+	const uint8_t *data = dataset->data + info->offset;
+	if (dataset->header.codec == DATASET_RAW) {
+		memcpy(out, data, info->rawSize);
+		return true;
+	}
+#ifdef HAVE_ZLIB
+	uLongf size = info->rawSize;
+	return uncompress(out, &size, data, info->size) == Z_OK && size == info->rawSize;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board.h"
+
+#define DATASET_VERSION 1
+#define DATASET_DEFAULT_CHUNK_ROWS (1 << 16)
+
+// One transition of a game: the board before a move, the move, the score it
+// gained and the board after it and the following spawn.
+typedef struct {
+	Board board;
+	Board next;
+	uint32_t game;
+	uint32_t moveNumber;
+	int32_t reward;
+	uint8_t move;
+} Transition;
+
+// Each transition field is stored as its own column, chunk by chunk.
+typedef enum {
+	DATASET_BOARD,
+	DATASET_NEXT,
+	DATASET_GAME,
+	DATASET_MOVE_NUMBER,
+	DATASET_REWARD,
+	DATASET_MOVE,
+	DATASET_COLUMNS
+} DatasetColumn;
+
+typedef enum {
+	DATASET_RAW,
+	DATASET_ZLIB
+} DatasetCodec;
+
+// Bytes per row of each column.
+extern const uint8_t datasetColumnSize[DATASET_COLUMNS];
+
+// A dataset file is a DatasetHeader, the chunks' columns, each starting on a
+// 64 byte boundary, and an index of DatasetChunk entries at indexOffset. Raw
+// columns can be used straight from a mapping of the file.
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t codec;
+	uint64_t rows;
+	uint64_t indexOffset;
+	uint32_t chunks;
+	uint32_t reserved;
+} DatasetHeader;
+
+typedef struct {
+	uint64_t offset;
+	uint32_t size;      // bytes stored in the file
+	uint32_t rawSize;   // bytes once decompressed
+} DatasetColumnInfo;
+
+// Ranges over the rows of a chunk, so readers can skip chunks without reading them.
+typedef struct {
+	uint32_t rows;
+	uint8_t minMaxTile, maxMaxTile;   // largest tile on board, as an exponent
+	uint16_t reserved;
+	uint32_t minMoveNumber, maxMoveNumber;
+	uint32_t minGame, maxGame;
+	DatasetColumnInfo columns[DATASET_COLUMNS];
+} DatasetChunk;
+
+typedef struct DatasetWriter DatasetWriter;
+
+// Whether this build can write and read DATASET_ZLIB files.
+bool datasetHasZlib(void);
+
+// Starts a dataset file with chunks of chunkRows transitions. With background,
+// full chunks are compressed and written by a thread of their own while the
+// next chunk fills up.
+DatasetWriter *datasetCreate(const char *path, int chunkRows, DatasetCodec codec, bool background);
+
+void datasetAppend(DatasetWriter *writer, const Transition *transition);
+
+// Writes the last chunk and the index and frees the writer. Returns false if
+// any write failed.
+bool datasetFinish(DatasetWriter *writer);
+
+typedef struct {
+	DatasetHeader header;
+	const DatasetChunk *chunks;
+	const uint8_t *data;
+	size_t size;
+} Dataset;
+
+// Maps a dataset file read-only and checks its header and index.
+bool datasetOpen(Dataset *dataset, const char *path);
+void datasetClose(Dataset *dataset);
+
+// Column of a raw dataset, read in place from the mapping, or NULL if compressed.
+const void *datasetColumnData(const Dataset *dataset, int chunk, DatasetColumn column);
+
+// Copies or decompresses a column of a chunk into out, which must hold
+// rows * datasetColumnSize[column] bytes.
+bool datasetReadColumn(const Dataset *dataset, int chunk, DatasetColumn column, void *out);
+
+#endif
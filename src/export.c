@@ -0,0 +1,179 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "ai.h"
+#include "rollout.h"
+#include "policy.h"
+#include "dataset.h"
+#include "rng.h"
+#include "spawn.h"
+#include "clock.h"
+
+static long long exportGame(DatasetWriter *writer, uint32_t game, Policy policy, const PolicyOptions *options, Rng *rng) {
+	Board board = boardSpawnRandom(boardSpawnRandom(0, rng, NULL), rng, NULL);
+	uint32_t moveNumber = 0;
+	int mask;
+	while ((mask = boardMoveMask(board)) != 0) {
+		Direction dir = policyMove(policy, board, mask, options, rng);
+		int reward = 0;
+		Board next = boardSpawnRandom(boardMove(board, dir, &reward), rng, NULL);
+		Transition transition = { board, next, game, moveNumber++, reward, (uint8_t)dir };
+		datasetAppend(writer, &transition);
+		board = next;
+	}
+	return moveNumber;
+}
+
+// Counts the transitions starting from a board with a tile of at least minTile,
+// reading only the chunks whose max tile range can hold one.
+static int scan(const char *path, int minTile) {
+	Dataset dataset;
+	if (!datasetOpen(&dataset, path)) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return 1;
+	}
+	Board *boards = NULL;
+	uint32_t capacity = 0;
+	uint32_t skipped = 0;
+	long long matches = 0;
+	for (uint32_t i = 0; i < dataset.header.chunks; i++) {
+		const DatasetChunk *chunk = &dataset.chunks[i];
+		if (chunk->maxMaxTile < minTile) {
+			skipped++;
+			continue;
+		}
+		const Board *column = datasetColumnData(&dataset, i, DATASET_BOARD);
+		if (!column) {
+			if (chunk->rows > capacity) {
+				capacity = chunk->rows;
+				free(boards);
+				boards = malloc(capacity * sizeof(Board));
+			}
+			if (!boards || !datasetReadColumn(&dataset, i, DATASET_BOARD, boards)) {
+				fprintf(stderr, "Could not read chunk %u of %s\n", i, path);
+				free(boards);
+				datasetClose(&dataset);
+				return 1;
+			}
+			column = boards;
+		}
+		for (uint32_t row = 0; row < chunk->rows; row++) {
+			matches += boardMaxTile(column[row]) >= minTile;
+		}
+	}
+	printf("%s: %llu transitions in %u chunks (%s), %u chunks skipped\n", path,
+		(unsigned long long)dataset.header.rows, dataset.header.chunks,
+		dataset.header.codec == DATASET_ZLIB ? "zlib" : "raw", skipped);
+	printf("%lld transitions from a board with a %d tile or more\n", matches, 1 << minTile);
+	free(boards);
+	datasetClose(&dataset);
+	return 0;
+}
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [-n games] [-p policy] [-s seed] [-d depth] [-k playouts] [-w weights]\n", program);
+	fprintf(stderr, "          [-o file] [-c chunk-rows] [-z raw|zlib] [-j]\n");
+	fprintf(stderr, "       %s -i file [-m min-tile]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+	int games = 1000;
+	Policy policy = POLICY_RANDOM;
+	uint64_t seed = (uint64_t)time(NULL);
+	PolicyOptions options = { AI_DEFAULT_DEPTH, ROLLOUT_DEFAULT_PLAYOUTS };
+	const char *weights = NULL;
+	const char *output = "transitions.ds";
+	const char *input = NULL;
+	int chunkRows = DATASET_DEFAULT_CHUNK_ROWS;
+	DatasetCodec codec = datasetHasZlib() ? DATASET_ZLIB : DATASET_RAW;
+	bool background = false;
+	int minTile = 2048;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			policy = policyFromName(argv[++i]);
+			if (policy == POLICY_COUNT) {
+				usage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			options.depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			options.playouts = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			weights = argv[++i];
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output = argv[++i];
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			chunkRows = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+			const char *name = argv[++i];
+			if (strcmp(name, "raw") == 0) {
+				codec = DATASET_RAW;
+			} else if (strcmp(name, "zlib") == 0 && datasetHasZlib()) {
+				codec = DATASET_ZLIB;
+			} else {
+				usage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			background = true;
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			input = argv[++i];
+		} else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			minTile = atoi(argv[++i]);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (games <= 0 || chunkRows <= 0 || options.depth <= 0 || options.playouts <= 0 || minTile < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	boardInit();
+
+	if (input) return scan(input, 31 - __builtin_clz((unsigned)minTile));
+
+	aiInit();
+	if (weights && !aiLoadWeights(weights)) {
+		fprintf(stderr, "Could not load weights from %s\n", weights);
+		return 1;
+	}
+
+	DatasetWriter *writer = datasetCreate(output, chunkRows, codec, background);
+	if (!writer) {
+		fprintf(stderr, "Could not create %s\n", output);
+		return 1;
+	}
+
+	double start = clockNow();
+	long long transitions = 0;
+	for (int i = 0; i < games; i++) {
+		Rng rng;
+		rngSeedStream(&rng, seed, (uint64_t)i);
+		transitions += exportGame(writer, (uint32_t)i, policy, &options, &rng);
+	}
+	if (!datasetFinish(writer)) {
+		fprintf(stderr, "Could not write %s\n", output);
+		return 1;
+	}
+	double seconds = clockNow() - start;
+
+	printf("policy %s, seed %llu\n", policyNames[policy], (unsigned long long)seed);
+	printf("%d games, %lld transitions in %.3f s to %s\n", games, transitions, seconds, output);
+	printf("transitions/s   %.1f\n", transitions / seconds);
+
+	return 0;
+}
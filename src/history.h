@@ -0,0 +1,75 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board.h"
+
+// Positions kept for undo; once full, the oldest is dropped. A power of two.
+#define HISTORY_CAPACITY 4096
+
+typedef struct {
+	Board board;
+	int score;
+} Snapshot;
+
+// Undo and redo stack in a fixed ring of snapshots, so every operation is O(1)
+// and nothing is allocated while playing. Slots [first, first + undo) hold the
+// positions before the current one, oldest first, and the next redo slots the
+// positions after it. Undo and redo swap the current position with the slot
+// at the boundary, so it moves from one side to the other in place.
+typedef struct {
+	Snapshot slots[HISTORY_CAPACITY];
+	uint32_t first;
+	uint32_t undo;
+	uint32_t redo;
+} History;
+
+static inline void historyClear(History *history) {
+	history->first = 0;
+	history->undo = 0;
+	history->redo = 0;
+}
+
+static inline Snapshot *historySlot(History *history, uint32_t index) {
+	return &history->slots[(history->first + index) & (HISTORY_CAPACITY - 1)];
+}
+
+static inline void historySwap(Snapshot *slot, Board *board, int *score) {
+	Snapshot current = { *board, *score };
+	*board = slot->board;
+	*score = slot->score;
+	*slot = current;
+}
+
+// Saves the current position before a move, which drops everything to redo.
+static inline void historyPush(History *history, Board board, int score) {
+	*historySlot(history, history->undo) = (Snapshot){ board, score };
+	history->redo = 0;
+	if (history->undo == HISTORY_CAPACITY) {
+		history->first++;
+	} else {
+		history->undo++;
+	}
+}
+
+// Swaps the current position for the one before it. False if there is none.
+static inline bool historyUndo(History *history, Board *board, int *score) {
+	if (history->undo == 0) return false;
+	history->undo--;
+	history->redo++;
+	historySwap(historySlot(history, history->undo), board, score);
+	return true;
+}
+
+// Swaps the current position for the one an undo left. False if there is none.
+static inline bool historyRedo(History *history, Board *board, int *score) {
+	if (history->redo == 0) return false;
+	historySwap(historySlot(history, history->undo), board, score);
+	history->undo++;
+	history->redo--;
+	return true;
+}
+
+#endif
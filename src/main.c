@@ -1,337 +1,358 @@
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 #include <time.h>
 
-#define SIZE 4
-
-typedef enum {
-	TILE_EMPTY,
-	TILE_2,
-	TILE_4,
-	TILE_8,
-	TILE_16,
-	TILE_32,
-	TILE_64,
-	TILE_128,
-	TILE_256,
-	TILE_512,
-	TILE_1024,
-	TILE_2048
-} TileValue;
+#include "board.h"
+#include "anim.h"
+#include "assets.h"
+#include "history.h"
+#include "ai.h"
+#include "rollout.h"
+#include "rng.h"
+#include "spawn.h"
+#include "replay.h"
 
-typedef struct {
-	TileValue value;
-	int xsrc, ysrc;
-	float tspawn, tslide;
-} Tile;
+// Exponent of the winning tile, 2048. Play can go on past it up to BOARD_MAX_TILE,
+// 32768, as two of those do not merge on the 4x4 board.
+#define WIN_TILE 11
 
 static float easeOutCubic(float t) {
 	return 1.0 - (1.0 - t) * (1.0 - t) * (1.0 - t);
 }
 
-static Color getColor(TileValue val) {
-	switch (val) {
-		case TILE_2:      return ColorFromHSV(225.0, 0.4, 0.3);   // dusty blue
-		case TILE_4:      return ColorFromHSV(210.0, 0.45, 0.32); // steely blue
-		case TILE_8:      return ColorFromHSV(200.0, 0.5, 0.35);  // dark cyan-blue
-		case TILE_16:     return ColorFromHSV(185.0, 0.5, 0.33);  // cold teal
-		case TILE_32:     return ColorFromHSV(170.0, 0.5, 0.31);  // murky aquamarine
-		case TILE_64:     return ColorFromHSV(255.0, 0.45, 0.36); // deep indigo
-		case TILE_128:    return ColorFromHSV(270.0, 0.5, 0.38);  // moody violet
-		case TILE_256:    return ColorFromHSV(285.0, 0.5, 0.4);   // soft purple
-		case TILE_512:    return ColorFromHSV(300.0, 0.5, 0.38);  // orchid
-		case TILE_1024:   return ColorFromHSV(315.0, 0.45, 0.35); // pink-magenta
-		case TILE_2048:   return ColorFromHSV(240.0, 0.5, 0.42);  // dark royal blue
-		case TILE_EMPTY:  exit(1);
+// Hue, saturation and value for the tiles from 2 up to 2048, by exponent.
+static const float tilePalette[WIN_TILE][3] = {
+	{ 225.0, 0.4, 0.3 },   // 2: dusty blue
+	{ 210.0, 0.45, 0.32 }, // 4: steely blue
+	{ 200.0, 0.5, 0.35 },  // 8: dark cyan-blue
+	{ 185.0, 0.5, 0.33 },  // 16: cold teal
+	{ 170.0, 0.5, 0.31 },  // 32: murky aquamarine
+	{ 255.0, 0.45, 0.36 }, // 64: deep indigo
+	{ 270.0, 0.5, 0.38 },  // 128: moody violet
+	{ 285.0, 0.5, 0.4 },   // 256: soft purple
+	{ 300.0, 0.5, 0.38 },  // 512: orchid
+	{ 315.0, 0.45, 0.35 }, // 1024: pink-magenta
+	{ 240.0, 0.5, 0.42 },  // 2048: dark royal blue
+};
+
+static Color getColor(int value) {
+	if (value <= WIN_TILE) {
+		const float *hsv = tilePalette[value - 1];
+		return ColorFromHSV(hsv[0], hsv[1], hsv[2]);
 	}
+	// Past 2048 the hue keeps turning and the tiles slowly get brighter.
+	int step = value - WIN_TILE;
+	return ColorFromHSV(fmodf(240.0 + 35.0 * step, 360.0), 0.55, fminf(0.42 + 0.03 * step, 0.6));
 }
 
-static void slideLeft(Tile board[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		int left = 0;
-		for (int x = 0; x < SIZE; x++) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[y][left].value = board[y][x].value;
-			board[y][left].xsrc = x;
-			left++;
-		}
-		for (int x = left; x < SIZE; x++) {
-			board[y][x].value = TILE_EMPTY;
-		}
-		for (int x = 0; x < left - 1; x++) {
-			if (board[y][x].value == board[y][x + 1].value) {
-				board[y][x].value++;
-				board[y][x + 1].value = TILE_EMPTY;
-				board[y][x].xsrc = board[y][x + 1].xsrc;
-				x++;
-			}
-		}
-		int final = 0;
-		for (int x = 0; x < left; x++) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[y][final].value = board[y][x].value;
-			board[y][final].xsrc = board[y][x].xsrc;
-			final++;
-		}
-		for (int x = final; x < SIZE; x++) {
-			board[y][x].value = TILE_EMPTY;
-		}
-	}
+// Tile value as text for any exponent below 90, written as 128k, 1M, 512G...
+// once it would take more than 5 digits.
+static const char *tileLabel(int value) {
+	static const char suffixes[] = " kMGTPEZY";
+	if (value <= 16) return TextFormat("%d", 1 << value);
+	return TextFormat("%d%c", 1 << (value % 10), suffixes[value / 10]);
 }
 
-static void slideRight(Tile board[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		int right = SIZE - 1;
-		for (int x = SIZE - 1; x >= 0; --x) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[y][right].value = board[y][x].value;
-			board[y][right].xsrc = x;
-			--right;
-		}
-		for (int x = right; x >= 0; --x) {
-			board[y][x].value = TILE_EMPTY;
-		}
-		for (int x = SIZE - 1; x > right + 1; --x) {
-			if (board[y][x].value == board[y][x - 1].value) {
-				board[y][x].value++;
-				board[y][x - 1].value = TILE_EMPTY;
-				board[y][x].xsrc = board[y][x - 1].xsrc;
-				x++;
-			}
-		}
-		int final = SIZE - 1;
-		for (int x = SIZE - 1; x > right; --x) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[y][final].value = board[y][x].value;
-			board[y][final].xsrc = board[y][x].xsrc;
-			--final;
-		}
-		for (int x = final; x >= 0; --x) {
-			board[y][x].value = TILE_EMPTY;
-		}
-	}
-}
+// Every tile value pre-rendered at the current tile size, so drawing a tile is
+// a single textured quad with no text layout. Sprites sit in a grid with a
+// pixel of padding each, so filtering never picks up a neighbour.
+#define ATLAS_COLUMNS 4
+#define ATLAS_ROWS ((BOARD_MAX_TILE + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS)
 
-static void slideUp(Tile board[SIZE][SIZE]) {
-	for (int x = 0; x < SIZE; x++) {
-		int top = 0;
-		for (int y = 0; y < SIZE; y++) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[top][x].value = board[y][x].value;
-			board[top][x].ysrc = y;
-			top++;
-		}
-		for (int y = top; y < SIZE; y++) {
-			board[y][x].value = TILE_EMPTY;
-		}
-		for (int y = 0; y < top - 1; y++) {
-			if (board[y][x].value == board[y + 1][x].value) {
-				board[y][x].value++;
-				board[y + 1][x].value = TILE_EMPTY;
-				board[y][x].ysrc = board[y + 1][x].ysrc;
-				y++;
-			}
-		}
-		int final = 0;
-		for (int y = 0; y < top; y++) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[final][x].value = board[y][x].value;
-			board[final][x].ysrc = board[y][x].ysrc;
-			final++;
-		}
-		for (int y = final; y < SIZE; y++) {
-			board[y][x].value = TILE_EMPTY;
-		}
-	}
+typedef struct {
+	RenderTexture2D target;
+	int tileWidth, tileHeight;
+} TileAtlas;
+
+static Rectangle atlasCell(const TileAtlas *atlas, int value) {
+	int index = value - 1;
+	return (Rectangle){
+		.x = (index % ATLAS_COLUMNS) * (atlas->tileWidth + 2) + 1,
+		.y = (index / ATLAS_COLUMNS) * (atlas->tileHeight + 2) + 1,
+		.width = atlas->tileWidth,
+		.height = atlas->tileHeight
+	};
 }
 
-static void slideDown(Tile board[SIZE][SIZE]) {
-	for (int x = 0; x < SIZE; x++) {
-		int bottom = SIZE - 1;
-		for (int y = SIZE - 1; y >= 0; --y) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[bottom][x].value = board[y][x].value;
-			board[bottom][x].ysrc = y;
-			--bottom;
-		}
-		for (int y = bottom; y >= 0; --y) {
-			board[y][x].value = TILE_EMPTY;
-		}
-		for (int y = SIZE - 1; y > bottom + 1; --y) {
-			if (board[y][x].value == board[y - 1][x].value) {
-				board[y][x].value++;
-				board[y - 1][x].value = TILE_EMPTY;
-				board[y][x].ysrc = board[y - 1][x].ysrc;
-				y++;
-			}
-		}
-		int final = SIZE - 1;
-		for (int y = SIZE - 1; y > bottom; --y) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			board[final][x].value = board[y][x].value;
-			board[final][x].ysrc = board[y][x].ysrc;
-			--final;
-		}
-		for (int y = final; y >= 0; --y) {
-			board[y][x].value = TILE_EMPTY;
-		}
+static void atlasBuild(TileAtlas *atlas, Font font, int tileWidth, int tileHeight) {
+	if (atlas->target.id != 0) UnloadRenderTexture(atlas->target);
+	atlas->tileWidth = tileWidth;
+	atlas->tileHeight = tileHeight;
+	atlas->target = LoadRenderTexture(ATLAS_COLUMNS * (tileWidth + 2), ATLAS_ROWS * (tileHeight + 2));
+	SetTextureFilter(atlas->target.texture, TEXTURE_FILTER_BILINEAR);
+	BeginTextureMode(atlas->target);
+	ClearBackground(BLANK);
+	// Blend alpha as "over" too, so antialiased label edges keep the sprite opaque.
+	rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+	BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+	for (int value = 1; value <= BOARD_MAX_TILE; value++) {
+		Rectangle cell = atlasCell(atlas, value);
+		const char* text = tileLabel(value);
+		float fontSize = fminf(cell.width, cell.height) * 0.36;
+		Vector2 textSize = MeasureTextEx(font, text, fontSize, 0.0);
+		if (textSize.x > 0.85 * cell.width) {
+			fontSize *= 0.85 * cell.width / textSize.x;
+			textSize = MeasureTextEx(font, text, fontSize, 0.0);
+		}
+		Vector2 textPos = {
+			cell.x + 0.5 * (cell.width - textSize.x),
+			cell.y + 0.5 * (cell.height - textSize.y)
+		};
+		DrawRectangleRounded(cell, 0.4, 8, getColor(value));
+		DrawTextEx(font, text, textPos, fontSize, 0.0, WHITE);
 	}
+	EndBlendMode();
+	EndTextureMode();
 }
 
-static bool anyMoved(Tile board[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		for (int x = 0; x < SIZE; x++) {
-			if (board[y][x].value == TILE_EMPTY) continue;
-			if (board[y][x].xsrc != x || board[y][x].ysrc != y) {
-				return true;
-			}
-		}
+// All tiles as one run of textured quads from the atlas, submitted through
+// rlgl as a single batch and draw call however many tiles there are.
+static void drawTiles(const TileAtlas *atlas, const Rectangle *rects, const int *values, int count) {
+	Texture2D texture = atlas->target.texture;
+	rlCheckRenderBatchLimit(4 * count);
+	rlSetTexture(texture.id);
+	rlBegin(RL_QUADS);
+	rlColor4ub(255, 255, 255, 255);
+	rlNormal3f(0.0, 0.0, 1.0);
+	for (int i = 0; i < count; i++) {
+		Rectangle src = atlasCell(atlas, values[i]);
+		Rectangle dst = rects[i];
+		float u0 = src.x / texture.width;
+		float u1 = (src.x + src.width) / texture.width;
+		// Render textures are stored upside down.
+		float v0 = 1.0 - src.y / texture.height;
+		float v1 = 1.0 - (src.y + src.height) / texture.height;
+		rlTexCoord2f(u0, v0);
+		rlVertex2f(dst.x, dst.y);
+		rlTexCoord2f(u0, v1);
+		rlVertex2f(dst.x, dst.y + dst.height);
+		rlTexCoord2f(u1, v1);
+		rlVertex2f(dst.x + dst.width, dst.y + dst.height);
+		rlTexCoord2f(u1, v0);
+		rlVertex2f(dst.x + dst.width, dst.y);
 	}
-	return false;
+	rlEnd();
+	rlSetTexture(0);
 }
 
-static void boardCopy(const Tile board[SIZE][SIZE], Tile copy[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		for (int x = 0; x < SIZE; x++) {
-			copy[y][x] = board[y][x];
-		}
-	}
+static void playJittered(Sound sound, Rng *rng) {
+	SetSoundPitch(sound, 1.0 + 0.2 * (2.0 * rngFloat(rng) - 1.0));
+	SetSoundVolume(sound, 1.0 - 0.1 * rngFloat(rng));
+	PlaySound(sound);
 }
 
-static void boardCommit(Tile board[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		for (int x = 0; x < SIZE; x++) {
-			board[y][x].xsrc = x;
-			board[y][x].ysrc = y;
-			board[y][x].tslide = 1.0;
-			board[y][x].tspawn = 1.0;
-		}
+static void drawDirectionGlow(int dir, int screenWidth, int screenHeight) {
+	if (dir == KEY_LEFT) {
+		DrawRectangleGradientH(0, 0, screenWidth / 2, screenHeight, ColorAlpha(WHITE, 0.1), ColorAlpha(WHITE, 0.0));
 	}
-}
-
-static bool isWon(const Tile board[SIZE][SIZE]) {
-	for (int y = 0; y < SIZE; y++) {
-		for (int x = 0; x < SIZE; x++) {
-			if (board[y][x].value == TILE_2048) {
-				return true;
-			}
-		}
+	if (dir == KEY_RIGHT) {
+		DrawRectangleGradientH(screenWidth / 2, 0, screenWidth, screenHeight, ColorAlpha(WHITE, 0.0), ColorAlpha(WHITE, 0.1));
+	}
+	if (dir == KEY_UP) {
+		DrawRectangleGradientV(0, 0, screenWidth, screenHeight / 2, ColorAlpha(WHITE, 0.1), ColorAlpha(WHITE, 0.0));
+	}
+	if (dir == KEY_DOWN) {
+		DrawRectangleGradientV(0, screenHeight / 2, screenWidth, screenHeight, ColorAlpha(WHITE, 0.0), ColorAlpha(WHITE, 0.1));
 	}
-	return false;
 }
 
-static bool isLost(const Tile board[SIZE][SIZE]) {
-
-	Tile result[SIZE][SIZE];
+// Monte Carlo or fixed depth search when asked for, otherwise as deep as fits in thinkTime on every core.
+static Direction suggestMove(Board board, int depth, int playouts, double thinkTime, Rng *rng) {
+	if (playouts > 0) return rolloutBestMove(board, playouts, 0, rngNext(rng));
+	if (depth > 0) return aiBestMove(board, depth);
+	return aiBestMoveTimed(board, 0, thinkTime, NULL);
+}
 
-	boardCopy(board, result);
-	boardCommit(result);
-	slideLeft(result);
-	if (anyMoved(result)) return false;
+// Everything besides animations that a frame shows. While it stays the same and
+// no tile is moving, the last frame is still correct and nothing is redrawn.
+typedef struct {
+	Board board;
+	int glowDir;
+	bool won, lost;
+	int width, height;
+} View;
+
+static bool viewEqual(View a, View b) {
+	return a.board == b.board && a.glowDir == b.glowDir && a.won == b.won && a.lost == b.lost
+		&& a.width == b.width && a.height == b.height;
+}
 
-	boardCopy(board, result);
-	boardCommit(result);
-	slideRight(result);
-	if (anyMoved(result)) return false;
+// Sleeps until there is new input. Music has to be streamed in regularly, so
+// while it plays this polls at a low rate instead of blocking.
+static void waitForInput(bool musicPlaying) {
+	if (musicPlaying) {
+		WaitTime(0.02);
+		PollInputEvents();
+		return;
+	}
+	EnableEventWaiting();
+	PollInputEvents();
+	DisableEventWaiting();
+}
 
-	boardCopy(board, result);
-	boardCommit(result);
-	slideUp(result);
-	if (anyMoved(result)) return false;
+// Hands the game being recorded to its writer thread without waiting. The one
+// ended before it has had a whole game to reach the disk, so waiting for that
+// is free.
+static void endRecording(ReplayRecorder **recording, ReplayRecorder **ending, int score) {
+	if (*ending && !replayRecordWait(*ending)) TraceLog(LOG_WARNING, "REPLAY: Could not write a replay");
+	*ending = *recording;
+	*recording = NULL;
+	if (*ending) replayRecordEnd(*ending, score);
+}
 
-	boardCopy(board, result);
-	boardCommit(result);
-	slideDown(result);
-	if (anyMoved(result)) return false;
+static bool isWon(Board board) {
+	return boardMaxTile(board) >= WIN_TILE;
+}
 
-	return true;
+static bool isLost(Board board) {
+	return boardMoveMask(board) == 0;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+
+	bool autoplay = false;
+	int depth = 0;
+	int playouts = 0;
+	const char *weights = NULL;
+	bool musicPlaying = true;
+	const char *recordDir = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--autoplay") == 0) {
+			autoplay = true;
+		} else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+			depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--playouts") == 0 && i + 1 < argc) {
+			playouts = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+			weights = argv[++i];
+		} else if (strcmp(argv[i], "--mute") == 0) {
+			musicPlaying = false;
+		} else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordDir = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--autoplay] [--depth n] [--playouts n] [--weights file] [--mute] [--record dir]\n", argv[0]);
+			return 1;
+		}
+	}
 
-	Tile board[SIZE][SIZE];
+	Board board;
+	Anim anim;
+	static History history;
+	int score = 0;
 	int tilesToSpawn;
 	bool won;
+	bool keepPlaying;
 	bool lost;
 
 
+	boardInit();
+	aiInit();
+	if (weights && !aiLoadWeights(weights)) {
+		fprintf(stderr, "Could not load weights from %s\n", weights);
+		return 1;
+	}
+
+	// Spawns have a stream of their own per game, so (seed, game) regenerates
+	// them however many hints were asked for or sounds played.
+	Rng spawnRng;
+	Rng rng;
+	uint64_t seed = (uint64_t)time(NULL);
+	ReplayRecorder *recording = NULL;
+	ReplayRecorder *ending = NULL;
+	int games = 0;
+
 	int screenWidth = 512;
 	int screenHeight = 512;
 
+	// Decoding starts first, so it overlaps opening the audio device and window.
+	Assets assets;
+	assetsLoad(&assets);
+
 	InitAudioDevice();
 
 	SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
 	InitWindow(screenWidth, screenHeight, "2048");
 	SetWindowMinSize(256, 256);
 
-	Font font = LoadFontEx("assets/font.ttf", 128, NULL, 0);
-	Sound slideSound = LoadSound("assets/pop.wav");
-	Sound stuckSound = LoadSound("assets/stuck.wav");
-	Sound winSound = LoadSound("assets/win.wav");
-	Sound loseSound = LoadSound("assets/lose.wav");
-	Sound restartSound = LoadSound("assets/restart.wav");
-	Music music = LoadMusicStream("assets/music.mp3");
-	PlayMusicStream(music);
-	SetMusicVolume(music, 0.2);
-	music.looping = true;
+	// The first frames draw with the default font and play no sound.
+	assets.font = GetFontDefault();
 
 	Color backgroundColor = ColorFromHSV(240.0, 0.4, 0.2);
 	float slidespeed = 4.0;
 	float spawnspeed = 4.0;
+	double thinkTime = 0.016;
 
 	Vector2 dragStartPos;
 	Vector2 dragEndPos;
 	bool draggingMouse = false;
 	int dragPreviewDir = KEY_NULL;
+	int hintDir = KEY_NULL;
+	static const int dirKeys[] = { KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN };
 
 	bool reset = true;
+	View shown = { 0 };
+	TileAtlas atlas = { 0 };
 
 	while (!WindowShouldClose()) {
 
-		UpdateMusicStream(music);
+		if (assetsPoll(&assets)) {
+			PlayMusicStream(assets.music);
+			SetMusicVolume(assets.music, 0.2);
+			assets.music.looping = true;
+			if (!musicPlaying) PauseMusicStream(assets.music);
+			// Tiles and text were drawn with the fallback font.
+			atlas.tileWidth = 0;
+			shown = (View){ 0 };
+		}
+
+		UpdateMusicStream(assets.music);
 
-		float dt = GetFrameTime();
+		// The first frame after an idle wait would otherwise count the whole wait.
+		float dt = fminf(GetFrameTime(), 0.05);
 
 		if (reset) {
 			reset = false;
+			rngSeedStream(&spawnRng, seed, (uint64_t)games);
+			rngSeedStream(&rng, seed, RNG_AUX_STREAM + (uint64_t)games);
+			if (recordDir) {
+				endRecording(&recording, &ending, score);
+				char path[4096];
+				snprintf(path, sizeof(path), "%s/game-%llu-%d.replay", recordDir, (unsigned long long)seed, games);
+				recording = replayRecord(path, seed, (uint64_t)games, BOARD_SIZE);
+				if (!recording) TraceLog(LOG_WARNING, "REPLAY: Could not start recording %s", path);
+			}
+			games++;
 			won = false;
+			keepPlaying = false;
 			lost = false;
-			for (int y = 0; y < SIZE; y++) {
-				for (int x = 0; x < SIZE; x++) {
-					board[y][x].value = TILE_EMPTY;
-					board[y][x].xsrc = x;
-					board[y][x].ysrc = y;
-					board[y][x].tspawn = 0.0;
-					board[y][x].tslide = 1.0;
-				}
-			}
+			board = 0;
+			score = 0;
+			animInit(&anim);
+			historyClear(&history);
 			tilesToSpawn = 2;
 		}
 
 		while (tilesToSpawn > 0) {
 			--tilesToSpawn;
-			int x, y;
-			do {
-				x = GetRandomValue(0, SIZE - 1);
-				y = GetRandomValue(0, SIZE - 1);
-			} while (board[y][x].value != TILE_EMPTY);
-			board[y][x].value = GetRandomValue(1, 8) == 8 ? TILE_4 : TILE_2;
-			board[y][x].xsrc = x;
-			board[y][x].ysrc = y;
-			board[y][x].tspawn = 0.0;
-			board[y][x].tslide = 1.0;
+			Spawn spawn = spawnPick(&spawnRng, boardCountEmpty(board));
+			animSpawn(&anim, boardEmptyCell(board, spawn.index));
+			board = boardSpawn(board, spawn.index, spawn.value);
+			if (recording) replayRecordSpawn(recording, spawn.empty, spawn.index, spawn.value);
 		}
 
 		if (!won && !lost) {
-			if (isWon(board)) {
-				PlaySound(winSound);
+			if (!keepPlaying && isWon(board)) {
+				PlaySound(assets.winSound);
 				won = true;
 			} else if (isLost(board)) {
-				PlaySound(loseSound);
+				PlaySound(assets.loseSound);
 				lost = true;
 			}
 		}
@@ -382,75 +403,128 @@ int main(void) {
 
 			int key = GetKeyPressed();
 
+			if (key == KEY_H) {
+				hintDir = dirKeys[suggestMove(board, depth, playouts, thinkTime, &rng)];
+			}
+
+			if (autoplay && dragDir == KEY_NULL && animSettled(&anim)) {
+				dragDir = dirKeys[suggestMove(board, depth, playouts, thinkTime, &rng)];
+			}
+
 			if (key != KEY_NULL || dragDir != KEY_NULL) {
 
-				boardCommit(board);
+				animSettle(&anim);
 
 				bool hasResult = false;
-				Tile result[SIZE][SIZE];
-				boardCopy(board, result);
+				Direction dir = DIR_LEFT;
 				if (key == KEY_LEFT || key == KEY_A || dragDir == KEY_LEFT) {
-					slideLeft(result);
+					dir = DIR_LEFT;
 					hasResult = true;
 				} else if (key == KEY_RIGHT || key == KEY_D || dragDir == KEY_RIGHT) {
-					slideRight(result);
+					dir = DIR_RIGHT;
 					hasResult = true;
 				} else if (key == KEY_UP || key == KEY_W || dragDir == KEY_UP) {
-					slideUp(result);
+					dir = DIR_UP;
 					hasResult = true;
 				} else if (key == KEY_DOWN || key == KEY_S || dragDir == KEY_DOWN) {
-					slideDown(result);
+					dir = DIR_DOWN;
 					hasResult = true;
 				}
 				if (hasResult) {
-					if (anyMoved(result)) {
-						boardCopy(result, board);
-						for (int y = 0; y < SIZE; y++) {
-							for (int x = 0; x < SIZE; x++) {
-								board[y][x].tslide = 0.0;
-							}
-						}
-						SetSoundPitch(slideSound, 1.0 + 0.2 * (2.0 * 0.01 * GetRandomValue(1, 100) - 1.0));
-						SetSoundVolume(slideSound, 1.0 - 0.1 * (0.01 * GetRandomValue(1, 100)));
-						PlaySound(slideSound);
+					if (boardMoveMask(board) & (1 << dir)) {
+						animSlide(&anim, board, dir);
+						historyPush(&history, board, score);
+						board = boardMove(board, dir, &score);
+						if (recording) replayRecordMove(recording, dir);
+						hintDir = KEY_NULL;
+						playJittered(assets.slideSound, &rng);
 						tilesToSpawn++;
 					} else {
-						SetSoundPitch(stuckSound, 1.0 + 0.2 * (2.0 * 0.01 * GetRandomValue(1, 100) - 1.0));
-						SetSoundVolume(stuckSound, 1.0 - 0.1 * (0.01 * GetRandomValue(1, 100)));
-						PlaySound(stuckSound);
+						playJittered(assets.stuckSound, &rng);
 					}
 				}
 			}
 		}
 
-		if (IsKeyPressed(KEY_R)) {
-			reset = true;
-			SetSoundPitch(restartSound, 1.0 + 0.2 * (2.0 * 0.01 * GetRandomValue(1, 100) - 1.0));
-			SetSoundVolume(restartSound, 1.0 - 0.1 * (0.01 * GetRandomValue(1, 100)));
-			PlaySound(restartSound);
+		// Autoplay games go on past 2048 by themselves.
+		if (won && (autoplay || IsKeyPressed(KEY_C))) {
+			won = false;
+			keepPlaying = true;
 		}
 
-		for (int y = 0; y < SIZE; y++) {
-			for (int x = 0; x < SIZE; x++) {
-				board[y][x].tslide = Clamp(board[y][x].tslide + slidespeed * dt, 0.0, 1.0);
-				board[y][x].tspawn = Clamp(board[y][x].tspawn + spawnspeed * dt, 0.0, 1.0);
+		if (IsKeyPressed(KEY_M)) {
+			musicPlaying = !musicPlaying;
+			if (musicPlaying) {
+				ResumeMusicStream(assets.music);
+			} else {
+				PauseMusicStream(assets.music);
 			}
 		}
 
+		bool undo = IsKeyPressed(KEY_Z) || IsKeyPressed(KEY_U);
+		bool redo = IsKeyPressed(KEY_Y);
+		if (undo || redo) {
+			// Replays have no way to express an undo, so one ends the recording.
+			if (recording && (undo ? history.undo : history.redo) > 0) {
+				endRecording(&recording, &ending, score);
+			}
+			if (undo ? historyUndo(&history, &board, &score) : historyRedo(&history, &board, &score)) {
+				animInit(&anim);
+				tilesToSpawn = 0;
+				won = false;
+				lost = false;
+				hintDir = KEY_NULL;
+				playJittered(assets.slideSound, &rng);
+			} else {
+				playJittered(assets.stuckSound, &rng);
+			}
+		}
+
+		if (IsKeyPressed(KEY_R)) {
+			reset = true;
+			hintDir = KEY_NULL;
+			playJittered(assets.restartSound, &rng);
+		}
+
+		animStep(&anim, slidespeed * dt, spawnspeed * dt);
+
 		screenWidth = GetScreenWidth();
 		screenHeight = GetScreenHeight();
 
+		View view = {
+			.board = board,
+			.glowDir = draggingMouse ? dragPreviewDir : hintDir,
+			.won = won,
+			.lost = lost,
+			.width = screenWidth,
+			.height = screenHeight
+		};
+		bool animating = reset || tilesToSpawn > 0 || !animSettled(&anim);
+		if (!animating && !IsWindowResized() && viewEqual(view, shown)) {
+			// While assets load, keep polling so they are picked up without input.
+			waitForInput(musicPlaying || assets.job);
+			continue;
+		}
+		shown = view;
+
+		float tileWidth = (float)screenWidth / (float)BOARD_SIZE;
+		float tileHeight = (float)screenHeight / (float)BOARD_SIZE;
+		if (atlas.tileWidth != (int)ceilf(tileWidth) || atlas.tileHeight != (int)ceilf(tileHeight)) {
+			atlasBuild(&atlas, assets.font, (int)ceilf(tileWidth), (int)ceilf(tileHeight));
+		}
+
 		BeginDrawing();
 		ClearBackground(backgroundColor);
 
-		float tileWidth = (float)screenWidth / (float)SIZE;
-		float tileHeight = (float)screenHeight / (float)SIZE;
-
-		for (int y = 0; y < SIZE; y++) {
-			for (int x = 0; x < SIZE; x++) {
-				TileValue value = board[y][x].value;
-				if (value == TILE_EMPTY) continue;
-				float scale = easeOutCubic(board[y][x].tspawn);
+		Rectangle tileRects[BOARD_CELLS];
+		int tileValues[BOARD_CELLS];
+		int tileCount = 0;
+		for (int y = 0; y < BOARD_SIZE; y++) {
+			for (int x = 0; x < BOARD_SIZE; x++) {
+				int value = boardGet(board, x, y);
+				if (value == 0) continue;
+				int cell = y * BOARD_SIZE + x;
+				float scale = easeOutCubic(anim.tspawn[cell]);
 				Vector2 tileSize = {
 					tileWidth * scale,
 					tileHeight * scale
@@ -459,32 +533,20 @@ int main(void) {
 					0.5 * (tileWidth - tileSize.x),
 					0.5 * (tileHeight - tileSize.y)
 				};
-				Vector2 srcPos = { board[y][x].xsrc * tileWidth, board[y][x].ysrc * tileHeight };
+				Vector2 srcPos = { (anim.src[cell] % BOARD_SIZE) * tileWidth, (anim.src[cell] / BOARD_SIZE) * tileHeight };
 				Vector2 dstPos = { x * tileWidth, y * tileHeight };
-				Vector2 tilePos = Vector2Add(tileOffset, Vector2Lerp(srcPos, dstPos, easeOutCubic(board[y][x].tslide)));
-				Color tileColor = getColor(value);
-				Rectangle tileRect = {
+				Vector2 tilePos = Vector2Add(tileOffset, Vector2Lerp(srcPos, dstPos, easeOutCubic(anim.tslide[cell])));
+				tileRects[tileCount] = (Rectangle){
 					.x = tilePos.x,
 					.y = tilePos.y,
 					.width = tileSize.x,
 					.height = tileSize.y
 				};
-				const char* text = TextFormat("%d", 1 << value);
-				float fontSize = fminf(tileSize.x, tileSize.y) * 0.36;
-				Vector2 textSize = MeasureTextEx(font, text, fontSize, 0.0);
-				Vector2 textOffset = {
-					0.5 * (tileSize.x - textSize.x),
-					0.5 * (tileSize.y - textSize.y)
-				};
-				Vector2 textPos = {
-					tilePos.x + textOffset.x,
-					tilePos.y + textOffset.y,
-				};
-				Color textColor = WHITE;
-				DrawRectangleRounded(tileRect, 0.4, 8, tileColor);
-				DrawTextEx(font, text, textPos, fontSize, 0.0, textColor);
+				tileValues[tileCount] = value;
+				tileCount++;
 			}
 		}
+		drawTiles(&atlas, tileRects, tileValues, tileCount);
 
 		if (draggingMouse) {
 			// if (dragPreviewDir != KEY_NULL) {
@@ -494,51 +556,40 @@ int main(void) {
 			// }
 			// DrawCircleGradient(dragStartPos.x, dragStartPos.y, 16.0, ColorAlpha(WHITE, 0.05), ColorAlpha(WHITE, 0.0));
 			// DrawCircleGradient(dragEndPos.x, dragEndPos.y, 16.0, ColorAlpha(WHITE, 0.05), ColorAlpha(WHITE, 0.0));
-			if (dragPreviewDir == KEY_LEFT) {
-				DrawRectangleGradientH(0, 0, screenWidth / 2, screenHeight, ColorAlpha(WHITE, 0.1), ColorAlpha(WHITE, 0.0));
-			}
-			if (dragPreviewDir == KEY_RIGHT) {
-				DrawRectangleGradientH(screenWidth / 2, 0, screenWidth, screenHeight, ColorAlpha(WHITE, 0.0), ColorAlpha(WHITE, 0.1));
-			}
-			if (dragPreviewDir == KEY_UP) {
-				DrawRectangleGradientV(0, 0, screenWidth, screenHeight / 2, ColorAlpha(WHITE, 0.1), ColorAlpha(WHITE, 0.0));
-			}
-			if (dragPreviewDir == KEY_DOWN) {
-				DrawRectangleGradientV(0, screenHeight / 2, screenWidth, screenHeight, ColorAlpha(WHITE, 0.0), ColorAlpha(WHITE, 0.1));
-			}
+			drawDirectionGlow(dragPreviewDir, screenWidth, screenHeight);
+		} else {
+			drawDirectionGlow(hintDir, screenWidth, screenHeight);
 		}
 
 		if (won || lost) {
 			const char* text;
 			if (won) {
-				text = "You won! :)\nPress R to play again";
+				text = "You won! :)\nPress C to keep going\n(32768s do not merge)\nor R to play again";
 			}
 			if (lost) {
 				text = "You lost... :(\nPress R to try again";
 			}
 			float fontSize = fminf(screenWidth, screenHeight) * 0.084;
-			Vector2 textSize = MeasureTextEx(font, text, fontSize, 0.0);
+			Vector2 textSize = MeasureTextEx(assets.font, text, fontSize, 0.0);
 			Vector2 textPos = {
 				0.5 * screenWidth - 0.5 * textSize.x,
 				0.5 * screenHeight - 0.5 * textSize.y,
 			};
 			Color textColor = WHITE;
-			DrawTextEx(font, text, textPos, fontSize, 0.0, textColor);
+			DrawTextEx(assets.font, text, textPos, fontSize, 0.0, textColor);
 		}
 
 		// DrawFPS(4, 4);
 		EndDrawing();
 	}
 
-	StopMusicStream(music);
+	endRecording(&recording, &ending, score);
+	if (ending && !replayRecordWait(ending)) TraceLog(LOG_WARNING, "REPLAY: Could not write a replay");
+
+	StopMusicStream(assets.music);
 
-	UnloadMusicStream(music);
-	UnloadFont(font);
-	UnloadSound(slideSound);
-	UnloadSound(stuckSound);
-	UnloadSound(winSound);
-	UnloadSound(loseSound);
-	UnloadSound(restartSound);
+	UnloadRenderTexture(atlas.target);
+	assetsUnload(&assets);
 
 	CloseAudioDevice();
 	CloseWindow();
@@ -0,0 +1,277 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ntuple.h"
+#include "simd.h"
+
+#define WEIGHTS_MAGIC "2048NTW"
+#define WEIGHTS_VERSION 2
+
+// Version 2 starts the tables on a huge page boundary so they can be mapped
+// with 2 MiB pages. The padding is left as a hole and takes no disk space.
+#define WEIGHTS_ALIGNMENT (2 << 20)
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t tuples;
+	uint32_t tableSize;
+	uint32_t reserved;
+	uint64_t dataOffset;
+} WeightsHeader;
+
+// Version 1 files had no dataOffset, the tables followed the 24 byte header.
+#define WEIGHTS_V1_HEADER 24
+
+static void symmetries(Board board, Board out[NTUPLE_SYMMETRIES]) {
+	Board transposed = boardTranspose(board);
+	out[0] = board;
+	out[1] = boardMirror(board);
+	out[2] = boardFlip(board);
+	out[3] = boardMirror(out[2]);
+	out[4] = transposed;
+	out[5] = boardMirror(transposed);
+	out[6] = boardFlip(transposed);
+	out[7] = boardMirror(out[6]);
+}
+
+// Cells of the tuples in order, two bent lines of six and two 2x3 blocks:
+//   0 1 2 3    . . . .    0 1 2 .    . . . .
+//   4 5 . .    0 1 2 3    3 4 5 .    0 1 2 .
+//   . . . .    4 5 . .    . . . .    3 4 5 .
+static void tupleIndices(Board board, uint32_t index[NTUPLE_TUPLES]) {
+	index[0] = (uint32_t)(board & 0xFFFFFF);
+	index[1] = (uint32_t)((board >> 16) & 0xFFFFFF);
+	index[2] = (uint32_t)((board & 0xFFF) | ((board >> 4) & 0xFFF000));
+	index[3] = (uint32_t)(((board >> 16) & 0xFFF) | ((board >> 20) & 0xFFF000));
+}
+
+bool ntupleCreate(NTuple *net) {
+	net->weights = calloc((size_t)NTUPLE_TUPLES * NTUPLE_TABLE, sizeof(float));
+	net->mapping = NULL;
+	net->mappingSize = 0;
+	return net->weights != NULL;
+}
+
+void ntupleDestroy(NTuple *net) {
+	if (net->mapping) {
+		munmap(net->mapping, net->mappingSize);
+	} else {
+		free(net->weights);
+	}
+	net->weights = NULL;
+	net->mapping = NULL;
+	net->mappingSize = 0;
+}
+
+float ntupleEvaluate(const NTuple *net, Board board) {
+	Board boards[NTUPLE_SYMMETRIES];
+	symmetries(board, boards);
+	float value = 0.0f;
+	for (int s = 0; s < NTUPLE_SYMMETRIES; s++) {
+		uint32_t index[NTUPLE_TUPLES];
+		tupleIndices(boards[s], index);
+		for (int t = 0; t < NTUPLE_TUPLES; t++) {
+			value += net->weights[(size_t)t * NTUPLE_TABLE + index[t]];
+		}
+	}
+	return value;
+}
+
+#ifdef SIMD_X86
+// Gathers the four tuple weights of one symmetry of four boards, in the scalar summation order.
+SIMD_AVX2_TARGET static inline __m128 gatherTuples4(const float *weights, __m256i b, __m128 value) {
+	__m256i low12 = _mm256_set1_epi64x(0xFFF);
+	__m256i high12 = _mm256_set1_epi64x(0xFFF000);
+	__m256i index0 = _mm256_and_si256(b, _mm256_set1_epi64x(0xFFFFFF));
+	__m256i index1 = _mm256_and_si256(_mm256_srli_epi64(b, 16), _mm256_set1_epi64x(0xFFFFFF));
+	__m256i index2 = _mm256_or_si256(_mm256_and_si256(b, low12), _mm256_and_si256(_mm256_srli_epi64(b, 4), high12));
+	__m256i index3 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(b, 16), low12), _mm256_and_si256(_mm256_srli_epi64(b, 20), high12));
+	value = _mm_add_ps(value, _mm256_i64gather_ps(weights, index0, 4));
+	value = _mm_add_ps(value, _mm256_i64gather_ps(weights + NTUPLE_TABLE, index1, 4));
+	value = _mm_add_ps(value, _mm256_i64gather_ps(weights + 2 * NTUPLE_TABLE, index2, 4));
+	value = _mm_add_ps(value, _mm256_i64gather_ps(weights + 3 * NTUPLE_TABLE, index3, 4));
+	return value;
+}
+
+SIMD_AVX2_TARGET static int evaluateAvx2(const NTuple *net, const Board *boards, int count, float *values) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256i board = _mm256_loadu_si256((const __m256i *)(boards + i));
+		__m256i flipped = simdFlip4(board);
+		__m256i transposed = simdTranspose4(board);
+		__m256i transposedFlipped = simdFlip4(transposed);
+		__m128 value = _mm_setzero_ps();
+		value = gatherTuples4(net->weights, board, value);
+		value = gatherTuples4(net->weights, simdMirror4(board), value);
+		value = gatherTuples4(net->weights, flipped, value);
+		value = gatherTuples4(net->weights, simdMirror4(flipped), value);
+		value = gatherTuples4(net->weights, transposed, value);
+		value = gatherTuples4(net->weights, simdMirror4(transposed), value);
+		value = gatherTuples4(net->weights, transposedFlipped, value);
+		value = gatherTuples4(net->weights, simdMirror4(transposedFlipped), value);
+		_mm_storeu_ps(values + i, value);
+	}
+	return i;
+}
+
+SIMD_AVX512_TARGET static inline __m256 gatherTuples8(const float *weights, __m512i b, __m256 value) {
+	__m512i low12 = _mm512_set1_epi64(0xFFF);
+	__m512i high12 = _mm512_set1_epi64(0xFFF000);
+	__m512i index0 = _mm512_and_si512(b, _mm512_set1_epi64(0xFFFFFF));
+	__m512i index1 = _mm512_and_si512(_mm512_srli_epi64(b, 16), _mm512_set1_epi64(0xFFFFFF));
+	__m512i index2 = _mm512_or_si512(_mm512_and_si512(b, low12), _mm512_and_si512(_mm512_srli_epi64(b, 4), high12));
+	__m512i index3 = _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi64(b, 16), low12), _mm512_and_si512(_mm512_srli_epi64(b, 20), high12));
+	value = _mm256_add_ps(value, _mm512_i64gather_ps(index0, weights, 4));
+	value = _mm256_add_ps(value, _mm512_i64gather_ps(index1, weights + NTUPLE_TABLE, 4));
+	value = _mm256_add_ps(value, _mm512_i64gather_ps(index2, weights + 2 * NTUPLE_TABLE, 4));
+	value = _mm256_add_ps(value, _mm512_i64gather_ps(index3, weights + 3 * NTUPLE_TABLE, 4));
+	return value;
+}
+
+SIMD_AVX512_TARGET static int evaluateAvx512(const NTuple *net, const Board *boards, int count, float *values) {
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m512i board = _mm512_loadu_si512((const void *)(boards + i));
+		__m512i flipped = simdFlip8(board);
+		__m512i transposed = simdTranspose8(board);
+		__m512i transposedFlipped = simdFlip8(transposed);
+		__m256 value = _mm256_setzero_ps();
+		value = gatherTuples8(net->weights, board, value);
+		value = gatherTuples8(net->weights, simdMirror8(board), value);
+		value = gatherTuples8(net->weights, flipped, value);
+		value = gatherTuples8(net->weights, simdMirror8(flipped), value);
+		value = gatherTuples8(net->weights, transposed, value);
+		value = gatherTuples8(net->weights, simdMirror8(transposed), value);
+		value = gatherTuples8(net->weights, transposedFlipped, value);
+		value = gatherTuples8(net->weights, simdMirror8(transposedFlipped), value);
+		_mm256_storeu_ps(values + i, value);
+	}
+	return i;
+}
+#endif
+
+void ntupleEvaluateBatch(const NTuple *net, const Board *boards, int count, float *values) {
+	int done = 0;
+#ifdef SIMD_X86
+	switch (simdLevel()) {
+		case SIMD_AVX512: done = evaluateAvx512(net, boards, count, values); // fall through
+		case SIMD_AVX2:   done += evaluateAvx2(net, boards + done, count - done, values + done); break;
+		case SIMD_SCALAR: break;
+	}
+#endif
+	for (int i = done; i < count; i++) {
+		values[i] = ntupleEvaluate(net, boards[i]);
+	}
+}
+
+void ntupleUpdate(NTuple *net, Board board, float delta) {
+	Board boards[NTUPLE_SYMMETRIES];
+	symmetries(board, boards);
+	float step = delta / (NTUPLE_TUPLES * NTUPLE_SYMMETRIES);
+	for (int s = 0; s < NTUPLE_SYMMETRIES; s++) {
+		uint32_t index[NTUPLE_TUPLES];
+		tupleIndices(boards[s], index);
+		for (int t = 0; t < NTUPLE_TUPLES; t++) {
+			net->weights[(size_t)t * NTUPLE_TABLE + index[t]] += step;
+		}
+	}
+}
+
+static size_t weightsBytes(void) {
+	return (size_t)NTUPLE_TUPLES * NTUPLE_TABLE * sizeof(float);
+}
+
+bool ntupleSave(const NTuple *net, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	WeightsHeader header = { WEIGHTS_MAGIC, WEIGHTS_VERSION, NTUPLE_TUPLES, NTUPLE_TABLE, 0, WEIGHTS_ALIGNMENT };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fseek(file, (long)header.dataOffset, SEEK_SET) == 0
+		&& fwrite(net->weights, 1, weightsBytes(), file) == weightsBytes();
+	return fclose(file) == 0 && ok;
+}
+
+// Checks the header and returns the offset of the tables, or 0 if the file is unusable.
+static uint64_t checkHeader(const void *data, size_t size) {
+	WeightsHeader header;
+	if (size < WEIGHTS_V1_HEADER) return 0;
+	memcpy(&header, data, size < sizeof(header) ? WEIGHTS_V1_HEADER : sizeof(header));
+	if (memcmp(header.magic, WEIGHTS_MAGIC, sizeof(header.magic)) != 0) return 0;
+	if (header.tuples != NTUPLE_TUPLES || header.tableSize != NTUPLE_TABLE) return 0;
+	uint64_t offset;
+	switch (header.version) {
+		case 1:  offset = WEIGHTS_V1_HEADER; break;
+		case 2:  offset = size >= sizeof(header) ? header.dataOffset : 0; break;
+		default: return 0;
+	}
+	if (offset == 0 || offset % sizeof(float) != 0 || offset + weightsBytes() > size) return 0;
+	return offset;
+}
+
+bool ntupleLoad(NTuple *net, const char *path) {
+	NTuple mapped;
+	if (!ntupleMap(&mapped, path, false)) return false;
+	bool ok = ntupleCreate(net);
+	if (ok) memcpy(net->weights, mapped.weights, weightsBytes());
+	ntupleDestroy(&mapped);
+	return ok;
+}
+
+// Maps the file at a WEIGHTS_ALIGNMENT aligned address, so the tables' file
+// offset and virtual address agree modulo a huge page and the kernel can back
+// them with 2 MiB pages. An anonymous region with room to spare is reserved and
+// the file mapped over its aligned part; the slack on both sides is returned.
+static void *mapAligned(int fd, size_t size) {
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t length = (size + page - 1) & ~(page - 1);
+	size_t reserved = length + WEIGHTS_ALIGNMENT;
+	char *region = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (region == MAP_FAILED) return MAP_FAILED;
+	char *base = (char *)(((uintptr_t)region + WEIGHTS_ALIGNMENT - 1) & ~(uintptr_t)(WEIGHTS_ALIGNMENT - 1));
+	if (mmap(base, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(region, reserved);
+		return MAP_FAILED;
+	}
+	if (base > region) munmap(region, (size_t)(base - region));
+	if (region + reserved > base + length) munmap(base + length, (size_t)(region + reserved - (base + length)));
+	return base;
+}
+
+bool ntupleMap(NTuple *net, const char *path, bool hugePages) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t)st.st_size;
+	void *mapping = mapAligned(fd, size);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	uint64_t offset = checkHeader(mapping, size);
+	if (offset == 0) {
+		munmap(mapping, size);
+		return false;
+	}
+#ifdef MADV_HUGEPAGE
+	if (hugePages) madvise(mapping, size, MADV_HUGEPAGE);
+#else
+	(void)hugePages;
+#endif
+	madvise(mapping, size, MADV_WILLNEED);
+
+	net->mapping = mapping;
+	net->mappingSize = size;
+	net->weights = (float *)((char *)mapping + offset);
+	return true;
+}
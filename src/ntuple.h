@@ -0,0 +1,43 @@
+#ifndef NTUPLE_H
+#define NTUPLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board.h"
+
+// Four 6-tuples, each sampled under all 8 symmetries of the board.
+#define NTUPLE_TUPLES 4
+#define NTUPLE_SYMMETRIES 8
+#define NTUPLE_TABLE (1 << 24)
+
+// Learned value of an afterstate: the expected score still to come.
+typedef struct {
+	float *weights;
+	void *mapping;
+	size_t mappingSize;
+} NTuple;
+
+bool ntupleCreate(NTuple *net);
+void ntupleDestroy(NTuple *net);
+
+float ntupleEvaluate(const NTuple *net, Board board);
+
+// ntupleEvaluate() for count boards, with AVX2 or AVX-512 gathers where available.
+void ntupleEvaluateBatch(const NTuple *net, const Board *boards, int count, float *values);
+
+// Moves the value of board by delta, spread evenly over every weight it reads.
+void ntupleUpdate(NTuple *net, Board board, float delta);
+
+bool ntupleSave(const NTuple *net, const char *path);
+
+// Reads a private, writable copy of the weights, for training.
+bool ntupleLoad(NTuple *net, const char *path);
+
+// Maps the weights file read-only and shared, so every process evaluating with
+// the same file uses one copy in the page cache and startup does no parsing.
+// With hugePages the kernel is asked to back the mapping with huge pages; files
+// on a hugetlbfs mount always are. The weights must not be updated.
+bool ntupleMap(NTuple *net, const char *path, bool hugePages);
+
+#endif
@@ -0,0 +1,98 @@
+#include <string.h>
+
+#include "policy.h"
+#include "ai.h"
+#include "rollout.h"
+
+const char *policyNames[POLICY_COUNT] = {
+	[POLICY_RANDOM] = "random",
+	[POLICY_GREEDY] = "greedy",
+	[POLICY_CORNER] = "corner",
+	[POLICY_EXPECTIMAX] = "expectimax",
+	[POLICY_MONTECARLO] = "montecarlo",
+};
+
+Policy policyFromName(const char *name) {
+	for (int i = 0; i < POLICY_COUNT; i++) {
+		if (strcmp(name, policyNames[i]) == 0) return (Policy)i;
+	}
+	return POLICY_COUNT;
+}
+
+static Direction randomMove(int mask, Rng *rng) {
+	int count = __builtin_popcount(mask);
+	int pick = (int)rngBelow(rng, count);
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		if (pick-- == 0) return (Direction)dir;
+	}
+	return DIR_LEFT;
+}
+
+// Most score gained this move, ties broken by the most empty cells left.
+static Direction greedyMove(Board board, int mask) {
+	Direction best = DIR_LEFT;
+	int bestValue = -1;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int score = 0;
+		Board result = boardMove(board, (Direction)dir, &score);
+		int value = score * BOARD_CELLS + boardCountEmpty(result);
+		if (value > bestValue) {
+			bestValue = value;
+			best = (Direction)dir;
+		}
+	}
+	return best;
+}
+
+// Keeps the largest tiles in the top left corner.
+static Direction cornerMove(int mask) {
+	static const Direction order[] = { DIR_UP, DIR_LEFT, DIR_RIGHT, DIR_DOWN };
+	for (int i = 0; i < 4; i++) {
+		if (mask & (1 << order[i])) return order[i];
+	}
+	return DIR_LEFT;
+}
+
+Direction policyMove(Policy policy, Board board, int mask, const PolicyOptions *options, Rng *rng) {
+	switch (policy) {
+		case POLICY_RANDOM: return randomMove(mask, rng);
+		case POLICY_GREEDY: return greedyMove(board, mask);
+		case POLICY_CORNER: return cornerMove(mask);
+		case POLICY_EXPECTIMAX: return aiBestMove(board, options->depth);
+		// Callers already run one game per core, so playouts stay on this thread.
+		case POLICY_MONTECARLO: return rolloutBestMove(board, options->playouts, 1, rngNext(rng));
+		case POLICY_COUNT:  break;
+	}
+	return randomMove(mask, rng);
+}
+
+bool policySupportsVariant(Policy policy) {
+	return policy == POLICY_RANDOM || policy == POLICY_GREEDY || policy == POLICY_CORNER;
+}
+
+static Direction greedyMoveVariant(const VariantOps *ops, VariantBoard board, int mask) {
+	Direction best = DIR_LEFT;
+	long long bestValue = -1;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		long long score = 0;
+		VariantBoard result = ops->move(board, (Direction)dir, &score);
+		long long value = score * ops->size * ops->size + ops->countEmpty(result);
+		if (value > bestValue) {
+			bestValue = value;
+			best = (Direction)dir;
+		}
+	}
+	return best;
+}
+
+Direction policyMoveVariant(Policy policy, const VariantOps *ops, VariantBoard board, int mask, Rng *rng) {
+	switch (policy) {
+		case POLICY_GREEDY: return greedyMoveVariant(ops, board, mask);
+		case POLICY_CORNER: return cornerMove(mask);
+		default: break;
+	}
+	return randomMove(mask, rng);
+}
@@ -0,0 +1,36 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "board.h"
+#include "rng.h"
+#include "variant.h"
+
+typedef enum {
+	POLICY_RANDOM,
+	POLICY_GREEDY,
+	POLICY_CORNER,
+	POLICY_EXPECTIMAX,
+	POLICY_MONTECARLO,
+	POLICY_COUNT
+} Policy;
+
+typedef struct {
+	int depth;     // expectimax search depth
+	int playouts;  // Monte Carlo playouts per move
+} PolicyOptions;
+
+extern const char *policyNames[POLICY_COUNT];
+
+// Returns POLICY_COUNT if the name is unknown.
+Policy policyFromName(const char *name);
+
+// Picks one of the legal directions in mask, which must be non-zero.
+Direction policyMove(Policy policy, Board board, int mask, const PolicyOptions *options, Rng *rng);
+
+// Random, greedy and corner on any board size; the search policies only play 4x4.
+bool policySupportsVariant(Policy policy);
+
+// As policyMove for a board played by ops, the policy must support variants.
+Direction policyMoveVariant(Policy policy, const VariantOps *ops, VariantBoard board, int mask, Rng *rng);
+
+#endif
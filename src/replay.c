@@ -0,0 +1,299 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "replay.h"
+#include "variant.h"
+
+#define REPLAY_MAGIC "2048RPL"
+
+// Recorded bytes are handed to the writer thread in blocks of this size. A
+// typical game fits in one, so the disk is touched once, when it ends.
+#define BLOCK_SIZE (64 << 10)
+
+typedef struct Block {
+	struct Block *next;
+	size_t used;
+	uint8_t data[BLOCK_SIZE];
+} Block;
+
+struct ReplayRecorder {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	// Shared with the writer thread, under lock.
+	Block *full;
+	Block **fullTail;
+	bool ended;
+	ReplayHeader final;
+	// Set by the writer thread before it exits.
+	bool ok;
+	// Owned by the recording thread.
+	ReplayHeader header;
+	Block *block;
+	bool dropped;
+	uint64_t bits;
+	int bitCount;
+	char path[];
+};
+
+// Bits needed for the index of one of empty cells.
+static int spawnBits(int empty) {
+	return empty <= 1 ? 0 : 32 - __builtin_clz((uint32_t)empty - 1);
+}
+
+static Block *newBlock(void) {
+	Block *block = malloc(sizeof(Block));
+	if (block) {
+		block->next = NULL;
+		block->used = 0;
+	}
+	return block;
+}
+
+static void handOff(ReplayRecorder *recorder, Block *block, bool ended) {
+	pthread_mutex_lock(&recorder->lock);
+	if (block) {
+		*recorder->fullTail = block;
+		recorder->fullTail = &block->next;
+	}
+	if (ended) {
+		recorder->ended = true;
+		recorder->final = recorder->header;
+	}
+	pthread_cond_signal(&recorder->wake);
+	pthread_mutex_unlock(&recorder->lock);
+}
+
+static void putByte(ReplayRecorder *recorder, uint8_t byte) {
+	if (recorder->block && recorder->block->used == BLOCK_SIZE) {
+		handOff(recorder, recorder->block, false);
+		recorder->block = newBlock();
+	}
+	if (!recorder->block) {
+		recorder->dropped = true;
+		return;
+	}
+	recorder->block->data[recorder->block->used++] = byte;
+}
+
+static void putBits(ReplayRecorder *recorder, uint32_t value, int count) {
+	recorder->bits |= (uint64_t)value << recorder->bitCount;
+	recorder->bitCount += count;
+	while (recorder->bitCount >= 8) {
+		putByte(recorder, (uint8_t)recorder->bits);
+		recorder->bits >>= 8;
+		recorder->bitCount -= 8;
+	}
+}
+
+static void *writerRun(void *arg) {
+	ReplayRecorder *recorder = arg;
+	FILE *file = fopen(recorder->path, "wb");
+	// The header stays zeroed until the game has ended, so a file cut short by
+	// a crash is never mistaken for a complete replay.
+	ReplayHeader header = { 0 };
+	bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1;
+	bool ended = false;
+	while (!ended) {
+		pthread_mutex_lock(&recorder->lock);
+		while (!recorder->full && !recorder->ended) {
+			pthread_cond_wait(&recorder->wake, &recorder->lock);
+		}
+		Block *blocks = recorder->full;
+		recorder->full = NULL;
+		recorder->fullTail = &recorder->full;
+		ended = recorder->ended;
+		header = recorder->final;
+		pthread_mutex_unlock(&recorder->lock);
+		while (blocks) {
+			Block *next = blocks->next;
+			ok = ok && fwrite(blocks->data, 1, blocks->used, file) == blocks->used;
+			free(blocks);
+			blocks = next;
+		}
+	}
+	ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	if (file) ok = fclose(file) == 0 && ok;
+	recorder->ok = ok;
+	return NULL;
+}
+
+ReplayRecorder *replayRecord(const char *path, uint64_t seed, uint64_t stream, int size) {
+	ReplayRecorder *recorder = calloc(1, sizeof(ReplayRecorder) + strlen(path) + 1);
+	if (!recorder) return NULL;
+	strcpy(recorder->path, path);
+	memcpy(recorder->header.magic, REPLAY_MAGIC, sizeof(recorder->header.magic));
+	recorder->header.version = REPLAY_VERSION;
+	recorder->header.rules = REPLAY_RULES;
+	recorder->header.seed = seed;
+	recorder->header.stream = stream;
+	recorder->header.size = (uint32_t)size;
+	recorder->fullTail = &recorder->full;
+	recorder->block = newBlock();
+	pthread_mutex_init(&recorder->lock, NULL);
+	pthread_cond_init(&recorder->wake, NULL);
+	if (!recorder->block || pthread_create(&recorder->thread, NULL, writerRun, recorder) != 0) {
+		pthread_cond_destroy(&recorder->wake);
+		pthread_mutex_destroy(&recorder->lock);
+		free(recorder->block);
+		free(recorder);
+		return NULL;
+	}
+	return recorder;
+}
+
+void replayRecordSpawn(ReplayRecorder *recorder, int empty, int index, int value) {
+	putBits(recorder, (uint32_t)index, spawnBits(empty));
+	putBits(recorder, (uint32_t)(value - 1), 1);
+	recorder->header.spawns++;
+}
+
+void replayRecordMove(ReplayRecorder *recorder, Direction dir) {
+	putBits(recorder, (uint32_t)dir, 2);
+	recorder->header.moves++;
+}
+
+void replayRecordEnd(ReplayRecorder *recorder, long long score) {
+	recorder->header.score = score;
+	if (recorder->bitCount > 0) {
+		putBits(recorder, 0, 8 - recorder->bitCount);
+	}
+	handOff(recorder, recorder->block, true);
+	recorder->block = NULL;
+}
+
+bool replayRecordWait(ReplayRecorder *recorder) {
+	pthread_join(recorder->thread, NULL);
+	bool ok = recorder->ok && !recorder->dropped;
+	pthread_cond_destroy(&recorder->wake);
+	pthread_mutex_destroy(&recorder->lock);
+	free(recorder);
+	return ok;
+}
+
+bool replayOpen(Replay *replay, const char *path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ReplayHeader)) {
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t)st.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	memcpy(&replay->header, mapping, sizeof(ReplayHeader));
+	const ReplayHeader *header = &replay->header;
+	if (memcmp(header->magic, REPLAY_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != REPLAY_VERSION || header->rules != REPLAY_RULES
+		|| !variantOps((int)header->size)) {
+		munmap(mapping, size);
+		return false;
+	}
+	replay->mapping = mapping;
+	replay->mappingSize = size;
+	replay->data = (const uint8_t *)mapping + sizeof(ReplayHeader);
+	replay->size = size - sizeof(ReplayHeader);
+	return true;
+}
+
+void replayClose(Replay *replay) {
+	if (replay->mapping) munmap(replay->mapping, replay->mappingSize);
+	replay->mapping = NULL;
+}
+
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} BitReader;
+
+// Hosts are little-endian, as for the weights format.
+static inline bool readBits(BitReader *reader, int count, uint32_t *value) {
+	if (reader->pos + count > reader->size * 8) return false;
+	size_t byte = reader->pos >> 3;
+	size_t avail = reader->size - byte;
+	uint64_t word = 0;
+	memcpy(&word, reader->data + byte, avail < 8 ? avail : 8);
+	*value = (uint32_t)(word >> (reader->pos & 7)) & ((1u << count) - 1);
+	reader->pos += count;
+	return true;
+}
+
+static inline bool readSpawn(BitReader *reader, int empty, int *index, int *value) {
+	uint32_t cell, four;
+	if (empty == 0 || !readBits(reader, spawnBits(empty), &cell) || cell >= (uint32_t)empty) return false;
+	if (!readBits(reader, 1, &four)) return false;
+	*index = (int)cell;
+	*value = 1 + (int)four;
+	return true;
+}
+
+// 4x4 games run on the packed board and its row tables.
+static bool playBoard(const ReplayHeader *header, BitReader *reader, ReplayResult *result) {
+	Board board = 0;
+	int score = 0;
+	int index, value;
+	for (int i = 0; i < 2; i++) {
+		if (!readSpawn(reader, boardCountEmpty(board), &index, &value)) return false;
+		board = boardSpawn(board, index, value);
+	}
+	uint32_t spawns = 2;
+	for (uint32_t move = 0; move < header->moves; move++) {
+		uint32_t dir;
+		if (!readBits(reader, 2, &dir) || !(boardMoveMask(board) & (1 << dir))) return false;
+		board = boardMove(board, (Direction)dir, &score);
+		if (spawns == header->spawns) break;
+		if (!readSpawn(reader, boardCountEmpty(board), &index, &value)) return false;
+		board = boardSpawn(board, index, value);
+		spawns++;
+	}
+	result->score = score;
+	result->maxTile = boardMaxTile(board);
+	return true;
+}
+
+static bool playVariant(const ReplayHeader *header, const VariantOps *ops, BitReader *reader, ReplayResult *result) {
+	VariantBoard board = { { 0 } };
+	long long score = 0;
+	int index, value;
+	for (int i = 0; i < 2; i++) {
+		if (!readSpawn(reader, ops->countEmpty(board), &index, &value)) return false;
+		board = ops->spawn(board, index, value);
+	}
+	uint32_t spawns = 2;
+	for (uint32_t move = 0; move < header->moves; move++) {
+		uint32_t dir;
+		if (!readBits(reader, 2, &dir) || !(ops->moveMask(board) & (1 << dir))) return false;
+		board = ops->move(board, (Direction)dir, &score);
+		if (spawns == header->spawns) break;
+		if (!readSpawn(reader, ops->countEmpty(board), &index, &value)) return false;
+		board = ops->spawn(board, index, value);
+		spawns++;
+	}
+	result->score = score;
+	result->maxTile = ops->maxTile(board);
+	return true;
+}
+
+bool replayPlay(const Replay *replay, ReplayResult *result) {
+	const ReplayHeader *header = &replay->header;
+	// Every move but possibly the last is followed by a spawn.
+	if (header->spawns < 2 || (header->spawns != header->moves + 2 && header->spawns != header->moves + 1)) return false;
+	BitReader reader = { replay->data, replay->size, 0 };
+	bool ok = header->size == BOARD_SIZE
+		? playBoard(header, &reader, result)
+		: playVariant(header, variantOps((int)header->size), &reader, result);
+	result->moves = header->moves;
+	return ok && result->score == header->score;
+}
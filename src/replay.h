@@ -0,0 +1,75 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board.h"
+
+#define REPLAY_VERSION 2
+
+// Bump when the rules change (spawn odds, merge cap), so old replays are refused
+// instead of silently playing out differently.
+#define REPLAY_RULES 2
+
+// A replay file is this header followed by a little-endian bit stream. The
+// game starts with two spawns, then every move is 2 bits of direction followed
+// by the spawn after it, if there was one. A spawn is the index of the chosen
+// cell among the empty ones, in just enough bits for the empty count, and 1 bit
+// for a 4 rather than a 2. Spawns are stored instead of regenerated from the
+// seed, so replays do not depend on how a player used the RNG.
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t rules;
+	uint64_t seed;     // rngSeedStream() seed and stream of the game's spawns,
+	uint64_t stream;   // the stream being the game number
+	uint32_t size;     // board side, 3 to 8
+	uint32_t moves;
+	uint32_t spawns;
+	uint32_t reserved;
+	int64_t score;     // final score, checked when replaying
+} ReplayHeader;
+
+typedef struct ReplayRecorder ReplayRecorder;
+
+// Starts recording a game to path. The file is opened and written by a thread of
+// the recorder's own, so none of the calls below wait for the disk.
+ReplayRecorder *replayRecord(const char *path, uint64_t seed, uint64_t stream, int size);
+
+// The index-th of empty empty cells got a tile of exponent value.
+void replayRecordSpawn(ReplayRecorder *recorder, int empty, int index, int value);
+
+void replayRecordMove(ReplayRecorder *recorder, Direction dir);
+
+// Ends the game and hands the rest of it to the writer thread without waiting.
+void replayRecordEnd(ReplayRecorder *recorder, long long score);
+
+// Waits for an ended recording to reach the disk and frees the recorder.
+// Returns false if the file could not be written.
+bool replayRecordWait(ReplayRecorder *recorder);
+
+typedef struct {
+	ReplayHeader header;
+	const uint8_t *data;
+	size_t size;
+	void *mapping;
+	size_t mappingSize;
+} Replay;
+
+typedef struct {
+	long long score;
+	int maxTile;
+	uint32_t moves;
+} ReplayResult;
+
+// Maps a replay file read-only and checks its header.
+bool replayOpen(Replay *replay, const char *path);
+void replayClose(Replay *replay);
+
+// Plays the game through again. Returns false if the stream is cut short, holds
+// an illegal move or spawn, or ends on a score other than the header's.
+bool replayPlay(const Replay *replay, ReplayResult *result);
+
+#endif
@@ -0,0 +1,74 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "replay.h"
+#include "clock.h"
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [-r repeat] [-q] replay...\n", program);
+}
+
+int main(int argc, char **argv) {
+
+	int repeat = 1;
+	bool quiet = false;
+	int first = 1;
+
+	for (; first < argc && argv[first][0] == '-'; first++) {
+		if (strcmp(argv[first], "-r") == 0 && first + 1 < argc) {
+			repeat = atoi(argv[++first]);
+		} else if (strcmp(argv[first], "-q") == 0) {
+			quiet = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (first == argc || repeat <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	boardInit();
+
+	int replays = 0;
+	int failed = 0;
+	long long moves = 0;
+	double seconds = 0.0;
+	for (int i = first; i < argc; i++) {
+		Replay replay;
+		if (!replayOpen(&replay, argv[i])) {
+			fprintf(stderr, "%s: not a replay\n", argv[i]);
+			failed++;
+			continue;
+		}
+		ReplayResult result;
+		bool ok = true;
+		double start = clockNow();
+		for (int r = 0; r < repeat && ok; r++) {
+			ok = replayPlay(&replay, &result);
+		}
+		seconds += clockNow() - start;
+		if (ok) {
+			replays++;
+			moves += (long long)result.moves * repeat;
+			if (!quiet) {
+				printf("%s: %dx%d, %u moves, score %lld, max tile %lld\n",
+					argv[i], replay.header.size, replay.header.size, result.moves, result.score, 1LL << result.maxTile);
+			}
+		} else {
+			fprintf(stderr, "%s: does not replay to the recorded game\n", argv[i]);
+			failed++;
+		}
+		replayClose(&replay);
+	}
+
+	printf("%d replays, %d failed, %lld moves in %.3f s\n", replays, failed, moves, seconds);
+	if (seconds > 0.0) printf("moves/s   %.1f\n", moves / seconds);
+
+	return failed != 0;
+}
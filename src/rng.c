@@ -0,0 +1,23 @@
+#include "rng.h"
+
+static uint64_t splitMix(uint64_t *state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void rngSeed(Rng *rng, uint64_t seed) {
+	for (int i = 0; i < 4; i++) {
+		rng->s[i] = splitMix(&seed);
+	}
+}
+
+// The seed is mixed before the stream is added, so (seed, stream) and (stream,
+// seed) differ. The sum is mixed again so neighbouring streams do not start
+// from overlapping splitMix sequences in rngSeed().
+void rngSeedStream(Rng *rng, uint64_t seed, uint64_t stream) {
+	uint64_t state = splitMix(&seed) + stream * 0x9E3779B97F4A7C15ULL;
+	rngSeed(rng, splitMix(&state));
+}
+
@@ -0,0 +1,56 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator. Seed every instance explicitly, one per thread or game.
+typedef struct {
+	uint64_t s[4];
+} Rng;
+
+void rngSeed(Rng *rng, uint64_t seed);
+
+// Independent stream number `stream` of a seed, e.g. one per simulated game.
+void rngSeedStream(Rng *rng, uint64_t seed, uint64_t stream);
+
+// Game numbers stay below this. A game's draws that must not shift its spawns,
+// such as AI seeds or sound jitter, come from stream RNG_AUX_STREAM + game.
+#define RNG_AUX_STREAM (1ULL << 63)
+
+static inline uint64_t rngRotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rngNext(Rng *rng) {
+	uint64_t *s = rng->s;
+	uint64_t result = rngRotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rngRotl(s[3], 45);
+	return result;
+}
+
+// Uniform integer in [0, bound), without modulo bias (Lemire's multiply and reject).
+static inline uint32_t rngBelow(Rng *rng, uint32_t bound) {
+	uint64_t m = (rngNext(rng) >> 32) * bound;
+	uint32_t low = (uint32_t)m;
+	if (low < bound) {
+		uint32_t threshold = -bound % bound;
+		while (low < threshold) {
+			m = (rngNext(rng) >> 32) * bound;
+			low = (uint32_t)m;
+		}
+	}
+	return (uint32_t)(m >> 32);
+}
+
+// Uniform float in [0, 1).
+static inline float rngFloat(Rng *rng) {
+	return (float)(rngNext(rng) >> 40) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+
+#include "rollout.h"
+#include "rng.h"
+#include "sched.h"
+#include "spawn.h"
+
+// Playouts per scheduler task, enough to hide the task overhead.
+#define BATCH 32
+
+typedef struct {
+	Board start;
+	int dir;
+	int count;
+	uint64_t stream;
+	double total;
+} Batch;
+
+typedef struct {
+	Batch *batches;
+	uint64_t seed;
+} Rollout;
+
+static int playout(Board board, Rng *rng) {
+	int score = 0;
+	int mask;
+	while ((mask = boardMoveMask(board)) != 0) {
+		int pick = (int)rngBelow(rng, __builtin_popcount(mask));
+		while (pick--) mask &= mask - 1;
+		board = boardMove(board, (Direction)__builtin_ctz(mask), &score);
+		board = boardSpawnRandom(board, rng, NULL);
+	}
+	return score;
+}
+
+static void runBatch(void *context, int task, int worker) {
+	(void)worker;
+	Rollout *rollout = context;
+	Batch *batch = &rollout->batches[task];
+	Rng rng;
+	rngSeedStream(&rng, rollout->seed, batch->stream);
+	double total = 0.0;
+	for (int i = 0; i < batch->count; i++) {
+		Board board = boardSpawnRandom(batch->start, &rng, NULL);
+		total += playout(board, &rng);
+	}
+	batch->total = total;
+}
+
+Direction rolloutBestMove(Board board, int playouts, int threads, uint64_t seed) {
+	if (playouts < 1) playouts = 1;
+	int perMove = (playouts + BATCH - 1) / BATCH;
+	Batch *batches = malloc(sizeof(Batch) * 4 * perMove);
+	double gained[4] = { 0.0 };
+	int count = 0;
+	int mask = boardMoveMask(board);
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int score = 0;
+		Board moved = boardMove(board, (Direction)dir, &score);
+		gained[dir] = score;
+		for (int i = 0; i < perMove; i++) {
+			int size = i == perMove - 1 ? playouts - i * BATCH : BATCH;
+			batches[count] = (Batch){ moved, dir, size, (uint64_t)count, 0.0 };
+			count++;
+		}
+	}
+
+	Rollout rollout = { batches, seed };
+	schedRun(count, threads, runBatch, &rollout);
+
+	double totals[4] = { 0.0 };
+	for (int i = 0; i < count; i++) {
+		totals[batches[i].dir] += batches[i].total;
+	}
+	free(batches);
+
+	Direction best = DIR_LEFT;
+	double bestMean = -1.0;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		double mean = gained[dir] + totals[dir] / playouts;
+		if (mean > bestMean) {
+			bestMean = mean;
+			best = (Direction)dir;
+		}
+	}
+	return best;
+}
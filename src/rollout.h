@@ -0,0 +1,16 @@
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+#include <stdint.h>
+
+#include "board.h"
+
+#define ROLLOUT_DEFAULT_PLAYOUTS 100
+
+// Pure Monte Carlo: after each legal move, plays `playouts` games to the end with
+// random moves and returns the move with the best mean final score. Playouts run
+// on `threads` threads (<= 0 for every core), each batch on its own RNG stream
+// of `seed`. The board must have at least one legal move.
+Direction rolloutBestMove(Board board, int playouts, int threads, uint64_t seed);
+
+#endif
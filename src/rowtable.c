@@ -0,0 +1,54 @@
+#include "rowtable.h"
+#include "board.h"
+
+RowSlide rowSlideLeft[65536];
+RowSlide rowSlideRight[65536];
+RowSlide rowSlide3Left[4096];
+RowSlide rowSlide3Right[4096];
+
+static uint16_t reverseRow(uint16_t row, int width) {
+	uint16_t result = 0;
+	for (int x = 0; x < width; x++) {
+		result |= (uint16_t)(((row >> (4 * x)) & 0xF) << (4 * (width - 1 - x)));
+	}
+	return result;
+}
+
+static uint16_t slideRow(uint16_t row, int width, uint32_t *score) {
+	int cells[4];
+	int count = 0;
+	for (int x = 0; x < width; x++) {
+		int value = (row >> (4 * x)) & 0xF;
+		if (value != 0) cells[count++] = value;
+	}
+	uint16_t result = 0;
+	int left = 0;
+	for (int i = 0; i < count; i++) {
+		int value = cells[i];
+		if (i + 1 < count && cells[i + 1] == value && value < BOARD_MAX_TILE) {
+			value++;
+			*score += 1u << value;
+			i++;
+		}
+		result |= (uint16_t)(value << (4 * left));
+		left++;
+	}
+	return result;
+}
+
+static void fillTables(RowSlide *leftTable, RowSlide *rightTable, int width) {
+	for (uint32_t i = 0; i < 1u << (4 * width); i++) {
+		uint16_t row = (uint16_t)i;
+		uint32_t score = 0;
+		uint16_t left = slideRow(row, width, &score);
+		leftTable[row] = (RowSlide){ left, left != row, score };
+		uint16_t reversed = reverseRow(row, width);
+		uint16_t right = reverseRow(left, width);
+		rightTable[reversed] = (RowSlide){ right, right != reversed, score };
+	}
+}
+
+void rowTableInit(void) {
+	fillTables(rowSlideLeft, rowSlideRight, 4);
+	fillTables(rowSlide3Left, rowSlide3Right, 3);
+}
@@ -0,0 +1,23 @@
+#ifndef ROWTABLE_H
+#define ROWTABLE_H
+
+#include <stdint.h>
+
+// Result of sliding one packed 16-bit row, indexed by the row before the slide.
+typedef struct {
+	uint16_t row;
+	uint16_t moved;
+	uint32_t score;
+} RowSlide;
+
+extern RowSlide rowSlideLeft[65536];
+extern RowSlide rowSlideRight[65536];
+
+// The same for the 12-bit rows of a 3x3 board.
+extern RowSlide rowSlide3Left[4096];
+extern RowSlide rowSlide3Right[4096];
+
+// Fills all tables. Must run once before any lookup.
+void rowTableInit(void);
+
+#endif
@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sched.h"
+
+// Chase-Lev deque with a fixed capacity. Only the owner pushes and takes at the
+// bottom, any thread may steal from the top.
+typedef struct {
+	_Atomic long top;
+	char padding[64];
+	_Atomic long bottom;
+	long capacity;
+	_Atomic int *tasks;
+} Deque;
+
+typedef enum {
+	STEAL_OK,
+	STEAL_EMPTY,
+	STEAL_RETRY
+} StealResult;
+
+typedef struct {
+	pthread_t thread;
+	int index;
+	Deque deque;
+} Worker;
+
+// Helper threads are started the first time a call needs them and then sleep
+// between calls. Worker 0 is always the calling thread.
+typedef struct {
+	Worker **workers;
+	int started;
+	_Atomic int *slots;
+	long slotCount;
+	// The current call, published under lock.
+	int threads;
+	void (*run)(void *context, int task, int worker);
+	void *context;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	unsigned generation;
+	int active;
+} Pool;
+
+static Pool pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER };
+
+// Held by the call using the pool.
+static pthread_mutex_t poolBusy = PTHREAD_MUTEX_INITIALIZER;
+
+static void dequePush(Deque *deque, int task) {
+	long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	atomic_store_explicit(&deque->tasks[b % deque->capacity], task, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
+static bool dequeTake(Deque *deque, int *task) {
+	long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+	if (t > b) {
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return false;
+	}
+	*task = atomic_load_explicit(&deque->tasks[b % deque->capacity], memory_order_relaxed);
+	if (t == b) {
+		bool won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return won;
+	}
+	return true;
+}
+
+static StealResult dequeSteal(Deque *deque, int *task) {
+	long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (t >= b) return STEAL_EMPTY;
+	*task = atomic_load_explicit(&deque->tasks[t % deque->capacity], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+		return STEAL_RETRY;
+	}
+	return STEAL_OK;
+}
+
+static void workerRun(Worker *worker) {
+	int task;
+	for (;;) {
+		while (dequeTake(&worker->deque, &task)) {
+			pool.run(pool.context, task, worker->index);
+		}
+		// Tasks never create tasks, so once every deque is seen empty the work is done.
+		bool contended = false;
+		bool stolen = false;
+		for (int i = 1; i < pool.threads && !stolen; i++) {
+			Worker *victim = pool.workers[(worker->index + i) % pool.threads];
+			StealResult result = dequeSteal(&victim->deque, &task);
+			if (result == STEAL_OK) stolen = true;
+			if (result == STEAL_RETRY) contended = true;
+		}
+		if (stolen) {
+			pool.run(pool.context, task, worker->index);
+		} else if (!contended) {
+			return;
+		}
+	}
+}
+
+static void *helperRun(void *arg) {
+	Worker *worker = arg;
+	unsigned seen = 0;
+	for (;;) {
+		pthread_mutex_lock(&pool.lock);
+		while (pool.generation == seen) {
+			pthread_cond_wait(&pool.wake, &pool.lock);
+		}
+		seen = pool.generation;
+		bool joins = worker->index < pool.threads;
+		pthread_mutex_unlock(&pool.lock);
+		if (!joins) continue;
+		workerRun(worker);
+		pthread_mutex_lock(&pool.lock);
+		if (--pool.active == 0) pthread_cond_signal(&pool.done);
+		pthread_mutex_unlock(&pool.lock);
+	}
+	return NULL;
+}
+
+// Stands for the calling thread, which only one call at a time can be.
+static Worker caller;
+
+// Makes room for threads workers, starting helpers as needed. Returns how many
+// there are, which is fewer if memory or threads ran out.
+static int poolReserve(int threads) {
+	if (threads > pool.started + 1) {
+		Worker **workers = realloc(pool.workers, threads * sizeof(Worker *));
+		if (workers) {
+			pool.workers = workers;
+			pool.workers[0] = &caller;
+			while (pool.started + 1 < threads) {
+				Worker *worker = calloc(1, sizeof(Worker));
+				if (!worker) break;
+				worker->index = pool.started + 1;
+				if (pthread_create(&worker->thread, NULL, helperRun, worker) != 0) {
+					free(worker);
+					break;
+				}
+				pool.workers[++pool.started] = worker;
+			}
+		}
+	}
+	return threads < pool.started + 1 ? threads : pool.started + 1;
+}
+
+int schedCores(void) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (int)cores : 1;
+}
+
+void schedRun(int count, int threads, void (*run)(void *context, int task, int worker), void *context) {
+	if (threads <= 0) threads = schedCores();
+	if (threads > count) threads = count;
+	// A call made while another one has the pool, say from several simulator
+	// threads at once, has every core busy already and runs on its own thread.
+	if (threads > 1 && pthread_mutex_trylock(&poolBusy) == 0) {
+		threads = poolReserve(threads);
+		long capacity = count / threads + 1;
+		if (threads > 1 && capacity * threads > pool.slotCount) {
+			_Atomic int *slots = realloc(pool.slots, (size_t)capacity * threads * sizeof(_Atomic int));
+			if (slots) {
+				pool.slots = slots;
+				pool.slotCount = capacity * threads;
+			} else {
+				threads = 1;
+			}
+		}
+		if (threads > 1) {
+			for (int i = 0; i < threads; i++) {
+				Deque *deque = &pool.workers[i]->deque;
+				atomic_init(&deque->top, 0);
+				atomic_init(&deque->bottom, 0);
+				deque->capacity = capacity;
+				deque->tasks = pool.slots + capacity * i;
+			}
+			for (int task = 0; task < count; task++) {
+				dequePush(&pool.workers[task % threads]->deque, task);
+			}
+
+			pthread_mutex_lock(&pool.lock);
+			pool.threads = threads;
+			pool.run = run;
+			pool.context = context;
+			pool.active = threads - 1;
+			pool.generation++;
+			pthread_cond_broadcast(&pool.wake);
+			pthread_mutex_unlock(&pool.lock);
+
+			workerRun(pool.workers[0]);
+
+			pthread_mutex_lock(&pool.lock);
+			while (pool.active > 0) {
+				pthread_cond_wait(&pool.done, &pool.lock);
+			}
+			pthread_mutex_unlock(&pool.lock);
+			pthread_mutex_unlock(&poolBusy);
+			return;
+		}
+		pthread_mutex_unlock(&poolBusy);
+	}
+	for (int task = 0; task < count; task++) {
+		run(context, task, 0);
+	}
+}
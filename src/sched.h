@@ -0,0 +1,16 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+// Runs run(context, task, worker) once for every task in [0, count) on a pool of
+// threads (threads <= 0 means one per core). Tasks are dealt round-robin into
+// per-thread work-stealing deques, so idle threads take work from busy ones and
+// uneven tasks balance out. The calling thread works as worker 0 and the call
+// returns once every task has finished. The threads are started by the first
+// call that needs them and kept for later ones; a call made while another is
+// running runs its tasks on the calling thread alone.
+void schedRun(int count, int threads, void (*run)(void *context, int task, int worker), void *context);
+
+// Number of online cores.
+int schedCores(void);
+
+#endif
@@ -0,0 +1,250 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "ai.h"
+#include "rollout.h"
+#include "policy.h"
+#include "rng.h"
+#include "variant.h"
+#include "replay.h"
+#include "spawn.h"
+#include "clock.h"
+
+typedef struct {
+	long long moves;
+	long long score;
+	int maxTile;
+} GameResult;
+
+// Per-thread totals, padded so workers never share a cache line.
+typedef struct {
+	long long moves;
+	double totalScore;
+	long long maxTiles[VARIANT_MAX_TILE + 1];
+	char padding[64];
+} SimStats;
+
+typedef struct {
+	pthread_t thread;
+	Policy policy;
+	PolicyOptions options;
+	const VariantOps *variant;
+	const char *recordDir;
+	uint64_t seed;
+	int first, count;
+	long long *scores;
+	SimStats stats;
+} Worker;
+
+static Board spawnTile(Board board, Rng *rng, ReplayRecorder *recorder) {
+	Spawn spawn;
+	board = boardSpawnRandom(board, rng, &spawn);
+	if (recorder) replayRecordSpawn(recorder, spawn.empty, spawn.index, spawn.value);
+	return board;
+}
+
+static GameResult playGame(Policy policy, const PolicyOptions *options, Rng *spawnRng, Rng *policyRng, ReplayRecorder *recorder) {
+	GameResult result = { 0 };
+	Board board = spawnTile(spawnTile(0, spawnRng, recorder), spawnRng, recorder);
+	int score = 0;
+	int mask;
+	while ((mask = boardMoveMask(board)) != 0) {
+		Direction dir = policyMove(policy, board, mask, options, policyRng);
+		if (recorder) replayRecordMove(recorder, dir);
+		board = boardMove(board, dir, &score);
+		board = spawnTile(board, spawnRng, recorder);
+		result.moves++;
+	}
+	result.score = score;
+	result.maxTile = boardMaxTile(board);
+	return result;
+}
+
+static VariantBoard spawnVariantTile(const VariantOps *ops, VariantBoard board, Rng *rng, ReplayRecorder *recorder) {
+	Spawn spawn;
+	board = variantSpawnRandom(ops, board, rng, &spawn);
+	if (recorder) replayRecordSpawn(recorder, spawn.empty, spawn.index, spawn.value);
+	return board;
+}
+
+static GameResult playVariantGame(Policy policy, const VariantOps *ops, Rng *spawnRng, Rng *policyRng, ReplayRecorder *recorder) {
+	GameResult result = { 0 };
+	VariantBoard board = { { 0 } };
+	board = spawnVariantTile(ops, spawnVariantTile(ops, board, spawnRng, recorder), spawnRng, recorder);
+	int mask;
+	while ((mask = ops->moveMask(board)) != 0) {
+		Direction dir = policyMoveVariant(policy, ops, board, mask, policyRng);
+		if (recorder) replayRecordMove(recorder, dir);
+		board = ops->move(board, dir, &result.score);
+		board = spawnVariantTile(ops, board, spawnRng, recorder);
+		result.moves++;
+	}
+	result.maxTile = ops->maxTile(board);
+	return result;
+}
+
+static void *workerRun(void *arg) {
+	Worker *worker = arg;
+	for (int i = 0; i < worker->count; i++) {
+		// Every game gets its own streams, so results do not depend on the thread
+		// count, and its spawns do not depend on how much the policy drew.
+		Rng spawnRng, policyRng;
+		uint64_t stream = (uint64_t)(worker->first + i);
+		rngSeedStream(&spawnRng, worker->seed, stream);
+		rngSeedStream(&policyRng, worker->seed, RNG_AUX_STREAM + stream);
+		ReplayRecorder *recorder = NULL;
+		if (worker->recordDir) {
+			char path[4096];
+			snprintf(path, sizeof(path), "%s/game-%llu.replay", worker->recordDir, (unsigned long long)stream);
+			recorder = replayRecord(path, worker->seed, stream, worker->variant ? worker->variant->size : BOARD_SIZE);
+			if (!recorder) fprintf(stderr, "Could not record %s\n", path);
+		}
+		// 4x4 games stay on the packed board, which every policy can play.
+		GameResult result = worker->variant
+			? playVariantGame(worker->policy, worker->variant, &spawnRng, &policyRng, recorder)
+			: playGame(worker->policy, &worker->options, &spawnRng, &policyRng, recorder);
+		if (recorder) {
+			replayRecordEnd(recorder, result.score);
+			if (!replayRecordWait(recorder)) fprintf(stderr, "Could not write replay of game %llu\n", (unsigned long long)stream);
+		}
+		worker->scores[worker->first + i] = result.score;
+		worker->stats.maxTiles[result.maxTile]++;
+		worker->stats.moves += result.moves;
+		worker->stats.totalScore += result.score;
+	}
+	return NULL;
+}
+
+static int compareScores(const void *a, const void *b) {
+	long long x = *(const long long *)a;
+	long long y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [-n games] [-p policy] [-s seed] [-t threads] [-d depth] [-k playouts] [-w weights] [-b size] [-r replay-dir]\n", program);
+	fprintf(stderr, "Policies:");
+	for (int i = 0; i < POLICY_COUNT; i++) {
+		fprintf(stderr, " %s", policyNames[i]);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+
+	int games = 1000;
+	Policy policy = POLICY_RANDOM;
+	uint64_t seed = (uint64_t)time(NULL);
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	PolicyOptions options = { AI_DEFAULT_DEPTH, ROLLOUT_DEFAULT_PLAYOUTS };
+	const char *weights = NULL;
+	int size = BOARD_SIZE;
+	const char *recordDir = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			policy = policyFromName(argv[++i]);
+			if (policy == POLICY_COUNT) {
+				usage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			options.depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			options.playouts = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			weights = argv[++i];
+		} else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			size = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			recordDir = argv[++i];
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (threads > games) threads = games;
+	if (games <= 0 || threads <= 0 || options.depth <= 0 || options.playouts <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	const VariantOps *variant = NULL;
+	if (size != BOARD_SIZE) {
+		variant = variantOps(size);
+		if (!variant) {
+			fprintf(stderr, "Board size must be between %d and %d\n", VARIANT_MIN_SIZE, VARIANT_MAX_SIZE);
+			return 1;
+		}
+		if (!policySupportsVariant(policy)) {
+			fprintf(stderr, "Policy %s only plays %dx%d boards\n", policyNames[policy], BOARD_SIZE, BOARD_SIZE);
+			return 1;
+		}
+	}
+
+	boardInit();
+	aiInit();
+	if (weights && !aiLoadWeights(weights)) {
+		fprintf(stderr, "Could not load weights from %s\n", weights);
+		return 1;
+	}
+
+	long long *scores = malloc(sizeof(long long) * games);
+	Worker *workers = calloc(threads, sizeof(Worker));
+
+	double start = clockNow();
+	for (int i = 0; i < threads; i++) {
+		workers[i].policy = policy;
+		workers[i].options = options;
+		workers[i].variant = variant;
+		workers[i].recordDir = recordDir;
+		workers[i].seed = seed;
+		workers[i].first = (int)((long long)games * i / threads);
+		workers[i].count = (int)((long long)games * (i + 1) / threads) - workers[i].first;
+		workers[i].scores = scores;
+		pthread_create(&workers[i].thread, NULL, workerRun, &workers[i]);
+	}
+	long long maxTiles[VARIANT_MAX_TILE + 1] = { 0 };
+	long long moves = 0;
+	double totalScore = 0.0;
+	for (int i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		for (int value = 0; value <= VARIANT_MAX_TILE; value++) {
+			maxTiles[value] += workers[i].stats.maxTiles[value];
+		}
+		moves += workers[i].stats.moves;
+		totalScore += workers[i].stats.totalScore;
+	}
+	double seconds = clockNow() - start;
+
+	qsort(scores, games, sizeof(long long), compareScores);
+
+	printf("policy %s, %dx%d, seed %llu, %d threads\n", policyNames[policy], size, size, (unsigned long long)seed, threads);
+	printf("%d games, %lld moves in %.3f s\n", games, moves, seconds);
+	printf("games/s   %.1f\n", games / seconds);
+	printf("moves/s   %.1f\n", moves / seconds);
+	printf("score     min %lld  p10 %lld  median %lld  p90 %lld  max %lld  mean %.1f\n",
+		scores[0], scores[games / 10], scores[games / 2], scores[games * 9 / 10], scores[games - 1], totalScore / games);
+	printf("max tile\n");
+	for (int value = 1; value <= VARIANT_MAX_TILE; value++) {
+		if (maxTiles[value] == 0) continue;
+		printf("  %6lld  %8lld  %6.2f%%\n", 1LL << value, maxTiles[value], 100.0 * maxTiles[value] / games);
+	}
+
+	free(workers);
+	free(scores);
+
+	return 0;
+}
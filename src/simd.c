@@ -0,0 +1,26 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd.h"
+
+static int detected = -1;
+static int cap = SIMD_AVX512;
+
+static SimdLevel detect(void) {
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+	return SIMD_SCALAR;
+}
+
+SimdLevel simdLevel(void) {
+	if (detected < 0) {
+		detected = detect();
+		const char *env = getenv("SIMD_LEVEL");
+		if (env && strcmp(env, "scalar") == 0) cap = SIMD_SCALAR;
+		if (env && strcmp(env, "avx2") == 0) cap = SIMD_AVX2;
+	}
+	return (SimdLevel)(detected < cap ? detected : cap);
+}
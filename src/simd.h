@@ -0,0 +1,76 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Runtime CPU dispatch for the batch evaluators. Kernels are compiled with
+// per-function target attributes, so the rest of the build needs no -mavx2.
+typedef enum {
+	SIMD_SCALAR,
+	SIMD_AVX2,
+	SIMD_AVX512
+} SimdLevel;
+
+// Best level this CPU supports, capped by the SIMD_LEVEL environment variable
+// (scalar, avx2 or avx512) when it is set.
+SimdLevel simdLevel(void);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+
+#define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#define SIMD_AVX512_TARGET __attribute__((target("avx512f")))
+
+// boardTranspose(), boardMirror() and boardFlip() on four boards at once.
+SIMD_AVX2_TARGET static inline __m256i simdTranspose4(__m256i b) {
+	__m256i a1 = _mm256_and_si256(b, _mm256_set1_epi64x((long long)0xF0F00F0FF0F00F0FULL));
+	__m256i a2 = _mm256_and_si256(b, _mm256_set1_epi64x(0x0000F0F00000F0F0LL));
+	__m256i a3 = _mm256_and_si256(b, _mm256_set1_epi64x(0x0F0F00000F0F0000LL));
+	__m256i a = _mm256_or_si256(a1, _mm256_or_si256(_mm256_slli_epi64(a2, 12), _mm256_srli_epi64(a3, 12)));
+	__m256i b1 = _mm256_and_si256(a, _mm256_set1_epi64x((long long)0xFF00FF0000FF00FFULL));
+	__m256i b2 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00FF00FF00000000LL));
+	__m256i b3 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00000000FF00FF00LL));
+	return _mm256_or_si256(b1, _mm256_or_si256(_mm256_srli_epi64(b2, 24), _mm256_slli_epi64(b3, 24)));
+}
+
+SIMD_AVX2_TARGET static inline __m256i simdMirror4(__m256i b) {
+	__m256i high = _mm256_set1_epi64x((long long)0xF0F0F0F0F0F0F0F0ULL);
+	b = _mm256_or_si256(_mm256_srli_epi64(_mm256_and_si256(b, high), 4), _mm256_slli_epi64(_mm256_andnot_si256(high, b), 4));
+	__m256i bytes = _mm256_set1_epi64x((long long)0xFF00FF00FF00FF00ULL);
+	return _mm256_or_si256(_mm256_srli_epi64(_mm256_and_si256(b, bytes), 8), _mm256_slli_epi64(_mm256_andnot_si256(bytes, b), 8));
+}
+
+SIMD_AVX2_TARGET static inline __m256i simdFlip4(__m256i b) {
+	__m256i middle = _mm256_or_si256(
+		_mm256_and_si256(_mm256_srli_epi64(b, 16), _mm256_set1_epi64x(0xFFFF0000LL)),
+		_mm256_and_si256(_mm256_slli_epi64(b, 16), _mm256_set1_epi64x(0xFFFF00000000LL)));
+	return _mm256_or_si256(middle, _mm256_or_si256(_mm256_srli_epi64(b, 48), _mm256_slli_epi64(b, 48)));
+}
+
+// The same on eight boards.
+SIMD_AVX512_TARGET static inline __m512i simdTranspose8(__m512i b) {
+	__m512i a1 = _mm512_and_si512(b, _mm512_set1_epi64((long long)0xF0F00F0FF0F00F0FULL));
+	__m512i a2 = _mm512_and_si512(b, _mm512_set1_epi64(0x0000F0F00000F0F0LL));
+	__m512i a3 = _mm512_and_si512(b, _mm512_set1_epi64(0x0F0F00000F0F0000LL));
+	__m512i a = _mm512_or_si512(a1, _mm512_or_si512(_mm512_slli_epi64(a2, 12), _mm512_srli_epi64(a3, 12)));
+	__m512i b1 = _mm512_and_si512(a, _mm512_set1_epi64((long long)0xFF00FF0000FF00FFULL));
+	__m512i b2 = _mm512_and_si512(a, _mm512_set1_epi64(0x00FF00FF00000000LL));
+	__m512i b3 = _mm512_and_si512(a, _mm512_set1_epi64(0x00000000FF00FF00LL));
+	return _mm512_or_si512(b1, _mm512_or_si512(_mm512_srli_epi64(b2, 24), _mm512_slli_epi64(b3, 24)));
+}
+
+SIMD_AVX512_TARGET static inline __m512i simdMirror8(__m512i b) {
+	__m512i high = _mm512_set1_epi64((long long)0xF0F0F0F0F0F0F0F0ULL);
+	b = _mm512_or_si512(_mm512_srli_epi64(_mm512_and_si512(b, high), 4), _mm512_slli_epi64(_mm512_andnot_si512(high, b), 4));
+	__m512i bytes = _mm512_set1_epi64((long long)0xFF00FF00FF00FF00ULL);
+	return _mm512_or_si512(_mm512_srli_epi64(_mm512_and_si512(b, bytes), 8), _mm512_slli_epi64(_mm512_andnot_si512(bytes, b), 8));
+}
+
+SIMD_AVX512_TARGET static inline __m512i simdFlip8(__m512i b) {
+	__m512i middle = _mm512_or_si512(
+		_mm512_and_si512(_mm512_srli_epi64(b, 16), _mm512_set1_epi64(0xFFFF0000LL)),
+		_mm512_and_si512(_mm512_slli_epi64(b, 16), _mm512_set1_epi64(0xFFFF00000000LL)));
+	return _mm512_or_si512(middle, _mm512_or_si512(_mm512_srli_epi64(b, 48), _mm512_slli_epi64(b, 48)));
+}
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include "board.h"
+#include "rng.h"
+#include "variant.h"
+
+// A random spawn: tile value (exponent) at the index-th of empty empty cells.
+typedef struct {
+	int empty;
+	int index;
+	int value;
+} Spawn;
+
+// The game's one spawn rule, used everywhere tiles appear: a uniformly chosen
+// empty cell gets a 4 once in BOARD_FOUR_ODDS spawns and a 2 otherwise. Bump
+// REPLAY_RULES when it changes.
+static inline Spawn spawnPick(Rng *rng, int empty) {
+	Spawn spawn = { empty, 0, 0 };
+	spawn.index = (int)rngBelow(rng, (uint32_t)empty);
+	spawn.value = rngBelow(rng, BOARD_FOUR_ODDS) == 0 ? 2 : 1;
+	return spawn;
+}
+
+// Spawns a random tile on a board with at least one empty cell, and reports
+// the spawn if asked to, e.g. for a replay.
+static inline Board boardSpawnRandom(Board board, Rng *rng, Spawn *spawn) {
+	Spawn picked = spawnPick(rng, boardCountEmpty(board));
+	if (spawn) *spawn = picked;
+	return boardSpawn(board, picked.index, picked.value);
+}
+
+static inline VariantBoard variantSpawnRandom(const VariantOps *ops, VariantBoard board, Rng *rng, Spawn *spawn) {
+	Spawn picked = spawnPick(rng, ops->countEmpty(board));
+	if (spawn) *spawn = picked;
+	return ops->spawn(board, picked.index, picked.value);
+}
+
+#endif
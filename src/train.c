@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "ntuple.h"
+#include "rng.h"
+#include "spawn.h"
+#include "clock.h"
+
+// TD(0) on afterstates: the network learns the score still to come after a move,
+// from games where it plays greedily on its own estimate.
+
+// Best move by immediate reward plus the value of the afterstate.
+static Board chooseMove(const NTuple *net, Board board, int mask, int *reward) {
+	Board best = board;
+	float bestValue = -1e30f;
+	for (int dir = DIR_LEFT; dir <= DIR_DOWN; dir++) {
+		if (!(mask & (1 << dir))) continue;
+		int gained = 0;
+		Board after = boardMove(board, (Direction)dir, &gained);
+		float value = gained + ntupleEvaluate(net, after);
+		if (value > bestValue) {
+			bestValue = value;
+			best = after;
+			*reward = gained;
+		}
+	}
+	return best;
+}
+
+static int playAndLearn(NTuple *net, float alpha, Rng *rng, int *maxTile) {
+	int score = 0;
+	Board board = boardSpawnRandom(boardSpawnRandom(0, rng, NULL), rng, NULL);
+	Board previous = 0;
+	bool hasPrevious = false;
+	int mask;
+	while ((mask = boardMoveMask(board)) != 0) {
+		int reward = 0;
+		Board after = chooseMove(net, board, mask, &reward);
+		if (hasPrevious) {
+			float target = reward + ntupleEvaluate(net, after);
+			ntupleUpdate(net, previous, alpha * (target - ntupleEvaluate(net, previous)));
+		}
+		previous = after;
+		hasPrevious = true;
+		score += reward;
+		board = boardSpawnRandom(after, rng, NULL);
+	}
+	if (hasPrevious) {
+		ntupleUpdate(net, previous, -alpha * ntupleEvaluate(net, previous));
+	}
+	*maxTile = boardMaxTile(board);
+	return score;
+}
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [-n games] [-a alpha] [-s seed] [-i weights] [-o weights]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+	int games = 100000;
+	float alpha = 0.1f;
+	uint64_t seed = (uint64_t)time(NULL);
+	const char *input = NULL;
+	const char *output = "weights.bin";
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+			alpha = (float)atof(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			input = argv[++i];
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output = argv[++i];
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	boardInit();
+
+	NTuple net;
+	if (input ? !ntupleLoad(&net, input) : !ntupleCreate(&net)) {
+		fprintf(stderr, "Could not %s weights\n", input ? "load" : "allocate");
+		return 1;
+	}
+
+	Rng rng;
+	rngSeed(&rng, seed);
+
+	int report = 1000;
+	double total = 0.0;
+	int reached2048 = 0;
+	double start = clockNow();
+	for (int i = 1; i <= games; i++) {
+		int maxTile;
+		total += playAndLearn(&net, alpha, &rng, &maxTile);
+		if (maxTile >= 11) reached2048++;
+		if (i % report == 0 || i == games) {
+			int played = i % report == 0 ? report : i % report;
+			printf("games %8d  mean score %9.1f  2048 rate %5.1f%%  %7.1f games/s\n",
+				i, total / played, 100.0 * reached2048 / played, i / (clockNow() - start));
+			fflush(stdout);
+			total = 0.0;
+			reached2048 = 0;
+		}
+	}
+
+	if (!ntupleSave(&net, output)) {
+		fprintf(stderr, "Could not write %s\n", output);
+		ntupleDestroy(&net);
+		return 1;
+	}
+	printf("wrote %s\n", output);
+	ntupleDestroy(&net);
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <math.h>
+
+#include "ttable.h"
+
+#define BUCKET_ENTRIES 4
+
+typedef struct {
+	_Atomic uint64_t check;
+	_Atomic uint64_t data;
+} Entry;
+
+struct TransTable {
+	Entry *entries;
+	uint64_t bucketMask;
+	atomic_uint age;
+};
+
+// Data layout: value (32 bits) | probability bound (16) | depth (8) | age (8).
+static uint64_t packData(float value, unsigned probability, unsigned depth, unsigned age) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return ((uint64_t)bits << 32) | ((uint64_t)probability << 16) | ((uint64_t)depth << 8) | age;
+}
+
+static float dataValue(uint64_t data) {
+	uint32_t bits = (uint32_t)(data >> 32);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static unsigned dataProbability(uint64_t data) { return (data >> 16) & 0xFFFF; }
+static unsigned dataDepth(uint64_t data) { return (data >> 8) & 0xFF; }
+static unsigned dataAge(uint64_t data) { return data & 0xFF; }
+
+// -log2(probability) in 1/1024 steps, so a smaller number is a more thorough search.
+static unsigned quantizeProbability(float probability) {
+	if (probability >= 1.0f) return 0;
+	float q = ceilf(-log2f(probability) * 1024.0f);
+	return q > 65535.0f ? 65535 : (unsigned)q;
+}
+
+TransTable *ttCreate(int bits) {
+	TransTable *table = malloc(sizeof(TransTable));
+	if (!table) return NULL;
+	size_t count = (size_t)1 << bits;
+	if (count < BUCKET_ENTRIES) count = BUCKET_ENTRIES;
+	table->entries = aligned_alloc(64, count * sizeof(Entry));
+	if (!table->entries) {
+		free(table);
+		return NULL;
+	}
+	for (size_t i = 0; i < count; i++) {
+		atomic_init(&table->entries[i].check, 0);
+		atomic_init(&table->entries[i].data, 0);
+	}
+	table->bucketMask = count / BUCKET_ENTRIES - 1;
+	atomic_init(&table->age, 1);
+	return table;
+}
+
+void ttDestroy(TransTable *table) {
+	if (!table) return;
+	free(table->entries);
+	free(table);
+}
+
+void ttNewSearch(TransTable *table) {
+	atomic_fetch_add_explicit(&table->age, 1, memory_order_relaxed);
+}
+
+static Entry *bucketFor(TransTable *table, uint64_t hash) {
+	return &table->entries[(hash & table->bucketMask) * BUCKET_ENTRIES];
+}
+
+bool ttProbe(TransTable *table, Board board, uint64_t hash, int depth, float probability, float *value) {
+	Entry *bucket = bucketFor(table, hash);
+	unsigned wanted = quantizeProbability(probability);
+	for (int i = 0; i < BUCKET_ENTRIES; i++) {
+		uint64_t data = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+		if ((check ^ data) != board || data == 0) continue;
+		if ((int)dataDepth(data) < depth || dataProbability(data) > wanted) return false;
+		*value = dataValue(data);
+		return true;
+	}
+	return false;
+}
+
+void ttStore(TransTable *table, Board board, uint64_t hash, int depth, float probability, float value) {
+	Entry *bucket = bucketFor(table, hash);
+	unsigned age = atomic_load_explicit(&table->age, memory_order_relaxed) & 0xFF;
+	uint64_t data = packData(value, quantizeProbability(probability), depth > 255 ? 255 : depth, age);
+
+	// Same position first, then an empty or stale slot, then the shallowest entry.
+	// A deeper result for the same position from this search is kept.
+	Entry *victim = NULL;
+	int victimScore = 1 << 30;
+	for (int i = 0; i < BUCKET_ENTRIES; i++) {
+		uint64_t old = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+		if (old != 0 && (check ^ old) == board) {
+			if (dataAge(old) == age && (int)dataDepth(old) > depth) return;
+			victim = &bucket[i];
+			break;
+		}
+		int score = old == 0 ? -2 : dataAge(old) != age ? -1 : (int)dataDepth(old);
+		if (score < victimScore) {
+			victimScore = score;
+			victim = &bucket[i];
+		}
+	}
+	atomic_store_explicit(&victim->data, data, memory_order_relaxed);
+	atomic_store_explicit(&victim->check, board ^ data, memory_order_relaxed);
+}
@@ -0,0 +1,29 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include <stdbool.h>
+
+#include "board.h"
+
+// Fixed-size transposition table shared by search threads without locks.
+// Entries are validated by storing key ^ data next to data, so a torn write
+// from another thread reads back as a miss instead of a wrong value.
+typedef struct TransTable TransTable;
+
+// Table with 2^bits entries, or NULL if out of memory.
+TransTable *ttCreate(int bits);
+void ttDestroy(TransTable *table);
+
+// Starts a new search generation, entries from older ones are replaced first.
+void ttNewSearch(TransTable *table);
+
+// Entries are found by hash, which must be uniformly distributed (a Zobrist hash
+// kept up to date along the search), and checked against board.
+
+// Finds a value searched at least as deep and at least as thoroughly (with a
+// probability cutoff no higher than this node's) as requested.
+bool ttProbe(TransTable *table, Board board, uint64_t hash, int depth, float probability, float *value);
+
+void ttStore(TransTable *table, Board board, uint64_t hash, int depth, float probability, float value);
+
+#endif
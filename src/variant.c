@@ -0,0 +1,194 @@
+#include <stddef.h>
+
+#include "variant.h"
+#include "rowtable.h"
+
+#define VARIANT_N 5
+#include "variant_impl.h"
+#undef VARIANT_N
+
+#define VARIANT_N 6
+#include "variant_impl.h"
+#undef VARIANT_N
+
+#define VARIANT_N 7
+#include "variant_impl.h"
+#undef VARIANT_N
+
+#define VARIANT_N 8
+#include "variant_impl.h"
+#undef VARIANT_N
+
+// 3x3 packs into the low 36 bits of a uint64_t, 4 bits per cell with rows of
+// 12 bits, and slides rows through the 4096-entry tables. Its largest tile is
+// far below BOARD_MAX_TILE, so nibbles never cap it.
+#define SIZE3 3
+#define CELLS3 (SIZE3 * SIZE3)
+
+static uint64_t toBoard3(VariantBoard board) {
+	uint64_t result = 0;
+	for (int y = 0; y < SIZE3; y++) {
+		for (int x = 0; x < SIZE3; x++) {
+			result |= ((board.rows[y] >> (8 * x)) & 0xF) << (4 * (y * SIZE3 + x));
+		}
+	}
+	return result;
+}
+
+static VariantBoard fromBoard3(uint64_t board) {
+	VariantBoard result = { { 0 } };
+	for (int y = 0; y < SIZE3; y++) {
+		for (int x = 0; x < SIZE3; x++) {
+			result.rows[y] |= ((board >> (4 * (y * SIZE3 + x))) & 0xF) << (8 * x);
+		}
+	}
+	return result;
+}
+
+// Swaps cells (x, y) and (y, x): the diagonal stays, the others move by 2 or 4 cells.
+static uint64_t transpose3(uint64_t board) {
+	return (board & 0xF000F000FULL)
+		| ((board & 0x00F000F0ULL) << 8) | ((board & 0xF000F000ULL) >> 8)
+		| ((board & 0xF00ULL) << 16) | ((board & 0xF000000ULL) >> 16);
+}
+
+static uint64_t slideRows3(uint64_t board, const RowSlide table[4096], long long *score) {
+	uint64_t result = 0;
+	for (int y = 0; y < SIZE3; y++) {
+		const RowSlide *slide = &table[(board >> (12 * y)) & 0xFFF];
+		result |= (uint64_t)slide->row << (12 * y);
+		*score += slide->score;
+	}
+	return result;
+}
+
+static VariantBoard variantMove3(VariantBoard board, Direction dir, long long *score) {
+	uint64_t packed = toBoard3(board);
+	long long gained = 0;
+	switch (dir) {
+		case DIR_LEFT:  packed = slideRows3(packed, rowSlide3Left, &gained); break;
+		case DIR_RIGHT: packed = slideRows3(packed, rowSlide3Right, &gained); break;
+		case DIR_UP:    packed = transpose3(slideRows3(transpose3(packed), rowSlide3Left, &gained)); break;
+		case DIR_DOWN:  packed = transpose3(slideRows3(transpose3(packed), rowSlide3Right, &gained)); break;
+	}
+	if (score) *score += gained;
+	return fromBoard3(packed);
+}
+
+static int variantMoveMask3(VariantBoard board) {
+	uint64_t packed = toBoard3(board);
+	uint64_t transposed = transpose3(packed);
+	int mask = 0;
+	for (int i = 0; i < SIZE3; i++) {
+		uint32_t row = (packed >> (12 * i)) & 0xFFF;
+		uint32_t column = (transposed >> (12 * i)) & 0xFFF;
+		mask |= rowSlide3Left[row].moved << DIR_LEFT;
+		mask |= rowSlide3Right[row].moved << DIR_RIGHT;
+		mask |= rowSlide3Left[column].moved << DIR_UP;
+		mask |= rowSlide3Right[column].moved << DIR_DOWN;
+	}
+	return mask;
+}
+
+static int variantCountEmpty3(VariantBoard board) {
+	uint64_t packed = toBoard3(board);
+	int count = 0;
+	for (int i = 0; i < CELLS3; i++) {
+		count += ((packed >> (4 * i)) & 0xF) == 0;
+	}
+	return count;
+}
+
+static VariantBoard variantSpawn3(VariantBoard board, int index, int value) {
+	uint64_t packed = toBoard3(board);
+	for (int i = 0; i < CELLS3; i++) {
+		if (((packed >> (4 * i)) & 0xF) != 0) continue;
+		if (index-- == 0) return fromBoard3(packed | ((uint64_t)value << (4 * i)));
+	}
+	return board;
+}
+
+static int variantMaxTile3(VariantBoard board) {
+	uint64_t packed = toBoard3(board);
+	int max = 0;
+	for (int i = 0; i < CELLS3; i++) {
+		int value = (int)((packed >> (4 * i)) & 0xF);
+		if (value > max) max = value;
+	}
+	return max;
+}
+
+static const VariantOps variantOps3 = {
+	SIZE3,
+	variantMove3,
+	variantMoveMask3,
+	variantCountEmpty3,
+	variantSpawn3,
+	variantMaxTile3,
+};
+
+// 4x4 converts to and from the packed 64-bit board and uses its row tables.
+// Its tiles stop at BOARD_MAX_TILE, so every exponent fits a nibble.
+static Board toBoard(VariantBoard board) {
+	Board result = 0;
+	for (int y = 0; y < BOARD_SIZE; y++) {
+		for (int x = 0; x < BOARD_SIZE; x++) {
+			result |= ((board.rows[y] >> (8 * x)) & 0xF) << (4 * (y * BOARD_SIZE + x));
+		}
+	}
+	return result;
+}
+
+static VariantBoard fromBoard(Board board) {
+	VariantBoard result = { { 0 } };
+	for (int y = 0; y < BOARD_SIZE; y++) {
+		for (int x = 0; x < BOARD_SIZE; x++) {
+			result.rows[y] |= ((board >> (4 * (y * BOARD_SIZE + x))) & 0xF) << (8 * x);
+		}
+	}
+	return result;
+}
+
+static VariantBoard variantMove4(VariantBoard board, Direction dir, long long *score) {
+	int gained = 0;
+	board = fromBoard(boardMove(toBoard(board), dir, &gained));
+	if (score) *score += gained;
+	return board;
+}
+
+static int variantMoveMask4(VariantBoard board) {
+	return boardMoveMask(toBoard(board));
+}
+
+static int variantCountEmpty4(VariantBoard board) {
+	return boardCountEmpty(toBoard(board));
+}
+
+static VariantBoard variantSpawn4(VariantBoard board, int index, int value) {
+	return fromBoard(boardSpawn(toBoard(board), index, value));
+}
+
+static int variantMaxTile4(VariantBoard board) {
+	return boardMaxTile(toBoard(board));
+}
+
+static const VariantOps variantOps4 = {
+	4,
+	variantMove4,
+	variantMoveMask4,
+	variantCountEmpty4,
+	variantSpawn4,
+	variantMaxTile4,
+};
+
+const VariantOps *variantOps(int size) {
+	switch (size) {
+		case 3: return &variantOps3;
+		case 4: return &variantOps4;
+		case 5: return &variantOps5;
+		case 6: return &variantOps6;
+		case 7: return &variantOps7;
+		case 8: return &variantOps8;
+	}
+	return NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board.h"
+
+#define VARIANT_MIN_SIZE 3
+#define VARIANT_MAX_SIZE 8
+
+// Two tiles of this exponent do not merge. Boards above 4x4 go far past the
+// 4x4 limit of BOARD_MAX_TILE; this one keeps a tile's value in a long long,
+// and so do the scores of variant games.
+#define VARIANT_MAX_TILE 62
+
+// Board of up to 8x8 cells, one 64-bit lane per row holding 8-bit exponents
+// (cell x of row y at bits 8 * x of rows[y]). Unused rows and cells stay zero.
+// This is only how boards are passed around: 3x3 and 4x4 are played on packed
+// nibble boards with row tables, larger sizes cell by cell.
+typedef struct {
+	uint64_t rows[VARIANT_MAX_SIZE];
+} VariantBoard;
+
+// Rules for one board size. Every size has its own implementation with the loop
+// bounds fixed at compile time; 3x3 and 4x4 forward to 64-bit packed engines.
+typedef struct {
+	int size;
+	VariantBoard (*move)(VariantBoard board, Direction dir, long long *score);
+	int (*moveMask)(VariantBoard board);
+	int (*countEmpty)(VariantBoard board);
+	VariantBoard (*spawn)(VariantBoard board, int index, int value);
+	int (*maxTile)(VariantBoard board);
+} VariantOps;
+
+// Rules for a size x size board, or NULL if the size is unsupported.
+const VariantOps *variantOps(int size);
+
+static inline int variantGet(VariantBoard board, int x, int y) {
+	return (board.rows[y] >> (8 * x)) & 0xFF;
+}
+
+static inline bool variantEqual(VariantBoard a, VariantBoard b) {
+	uint64_t diff = 0;
+	for (int y = 0; y < VARIANT_MAX_SIZE; y++) {
+		diff |= a.rows[y] ^ b.rows[y];
+	}
+	return diff == 0;
+}
+
+#endif
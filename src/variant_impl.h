@@ -0,0 +1,141 @@
+// Rules for one board size, included by variant.c once per size with
+// VARIANT_N defined, so every loop below has a compile-time bound.
+
+#define VARIANT_CAT(a, b) a##b
+#define VARIANT_NAME(name, n) VARIANT_CAT(name, n)
+#define FN(name) VARIANT_NAME(name, VARIANT_N)
+
+static uint64_t FN(slideRow)(uint64_t row, long long *score) {
+	int cells[VARIANT_N];
+	int count = 0;
+	for (int x = 0; x < VARIANT_N; x++) {
+		int value = (row >> (8 * x)) & 0xFF;
+		if (value != 0) cells[count++] = value;
+	}
+	uint64_t result = 0;
+	int left = 0;
+	for (int i = 0; i < count; i++) {
+		int value = cells[i];
+		if (i + 1 < count && cells[i + 1] == value && value < VARIANT_MAX_TILE) {
+			value++;
+			*score += 1LL << value;
+			i++;
+		}
+		result |= (uint64_t)value << (8 * left);
+		left++;
+	}
+	return result;
+}
+
+static uint64_t FN(reverseRow)(uint64_t row) {
+	uint64_t result = 0;
+	for (int x = 0; x < VARIANT_N; x++) {
+		result |= ((row >> (8 * x)) & 0xFF) << (8 * (VARIANT_N - 1 - x));
+	}
+	return result;
+}
+
+static VariantBoard FN(transpose)(VariantBoard board) {
+	VariantBoard result = { { 0 } };
+	for (int y = 0; y < VARIANT_N; y++) {
+		for (int x = 0; x < VARIANT_N; x++) {
+			result.rows[x] |= ((board.rows[y] >> (8 * x)) & 0xFF) << (8 * y);
+		}
+	}
+	return result;
+}
+
+static VariantBoard FN(slideRows)(VariantBoard board, bool reverse, long long *score) {
+	for (int y = 0; y < VARIANT_N; y++) {
+		if (reverse) {
+			board.rows[y] = FN(reverseRow)(FN(slideRow)(FN(reverseRow)(board.rows[y]), score));
+		} else {
+			board.rows[y] = FN(slideRow)(board.rows[y], score);
+		}
+	}
+	return board;
+}
+
+static VariantBoard FN(variantMove)(VariantBoard board, Direction dir, long long *score) {
+	long long gained = 0;
+	switch (dir) {
+		case DIR_LEFT:  board = FN(slideRows)(board, false, &gained); break;
+		case DIR_RIGHT: board = FN(slideRows)(board, true, &gained); break;
+		case DIR_UP:    board = FN(transpose)(FN(slideRows)(FN(transpose)(board), false, &gained)); break;
+		case DIR_DOWN:  board = FN(transpose)(FN(slideRows)(FN(transpose)(board), true, &gained)); break;
+	}
+	if (score) *score += gained;
+	return board;
+}
+
+// Bit 0 if the row can slide towards x = 0, bit 1 if towards the other end:
+// some tile has an empty cell on that side, or two neighbours are equal.
+static int FN(rowMoves)(uint64_t row) {
+	int moves = 0;
+	for (int x = 0; x + 1 < VARIANT_N; x++) {
+		int a = (row >> (8 * x)) & 0xFF;
+		int b = (row >> (8 * (x + 1))) & 0xFF;
+		bool merge = a != 0 && a == b && a < VARIANT_MAX_TILE;
+		if ((a == 0 && b != 0) || merge) moves |= 1;
+		if ((b == 0 && a != 0) || merge) moves |= 2;
+	}
+	return moves;
+}
+
+static int FN(variantMoveMask)(VariantBoard board) {
+	VariantBoard transposed = FN(transpose)(board);
+	int rows = 0;
+	int columns = 0;
+	for (int i = 0; i < VARIANT_N; i++) {
+		rows |= FN(rowMoves)(board.rows[i]);
+		columns |= FN(rowMoves)(transposed.rows[i]);
+	}
+	return ((rows & 1) << DIR_LEFT) | ((rows >> 1) << DIR_RIGHT) | ((columns & 1) << DIR_UP) | ((columns >> 1) << DIR_DOWN);
+}
+
+static int FN(variantCountEmpty)(VariantBoard board) {
+	int count = 0;
+	for (int y = 0; y < VARIANT_N; y++) {
+		for (int x = 0; x < VARIANT_N; x++) {
+			if (((board.rows[y] >> (8 * x)) & 0xFF) == 0) count++;
+		}
+	}
+	return count;
+}
+
+static VariantBoard FN(variantSpawn)(VariantBoard board, int index, int value) {
+	for (int y = 0; y < VARIANT_N; y++) {
+		for (int x = 0; x < VARIANT_N; x++) {
+			if (((board.rows[y] >> (8 * x)) & 0xFF) != 0) continue;
+			if (index-- == 0) {
+				board.rows[y] |= (uint64_t)value << (8 * x);
+				return board;
+			}
+		}
+	}
+	return board;
+}
+
+static int FN(variantMaxTile)(VariantBoard board) {
+	int max = 0;
+	for (int y = 0; y < VARIANT_N; y++) {
+		for (int x = 0; x < VARIANT_N; x++) {
+			int value = (board.rows[y] >> (8 * x)) & 0xFF;
+			if (value > max) max = value;
+		}
+	}
+	return max;
+}
+
+static const VariantOps FN(variantOps) = {
+	VARIANT_N,
+	FN(variantMove),
+	FN(variantMoveMask),
+	FN(variantCountEmpty),
+	FN(variantSpawn),
+	FN(variantMaxTile),
+};
+
+#undef FN
+#undef VARIANT_NAME
+#undef VARIANT_CAT
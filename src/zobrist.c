@@ -0,0 +1,45 @@
+#include "zobrist.h"
+#include "rng.h"
+
+#define ZOBRIST_SEED 2048
+
+uint64_t zobristKeys[BOARD_CELLS][16];
+uint64_t zobristImageKeys[BOARD_CELLS][16][ZOBRIST_IMAGES];
+
+void zobristInit(void) {
+	Rng rng;
+	rngSeed(&rng, ZOBRIST_SEED);
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		// Empty cells hash to nothing, so the empty board hashes to 0.
+		zobristKeys[cell][0] = 0;
+		for (int value = 1; value < 16; value++) {
+			zobristKeys[cell][value] = rngNext(&rng);
+		}
+	}
+	// Image i mirrors the columns if bit 0 is set, the rows if bit 1 is, and
+	// then transposes if bit 2 is; a tile's key in it is the key of its image.
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		for (int i = 0; i < ZOBRIST_IMAGES; i++) {
+			int x = cell % BOARD_SIZE;
+			int y = cell / BOARD_SIZE;
+			if (i & 1) x = BOARD_SIZE - 1 - x;
+			if (i & 2) y = BOARD_SIZE - 1 - y;
+			int image = i & 4 ? x * BOARD_SIZE + y : y * BOARD_SIZE + x;
+			for (int value = 0; value < 16; value++) {
+				zobristImageKeys[cell][value][i] = zobristKeys[image][value];
+			}
+		}
+	}
+}
+
+uint64_t zobristHash(Board board) {
+	uint64_t hash = 0;
+	for (int cell = 0; cell < BOARD_CELLS; cell++) {
+		hash ^= zobristKeys[cell][(board >> (4 * cell)) & 0xF];
+	}
+	return hash;
+}
+
+ZobristImages zobristImages(Board board) {
+	return zobristImagesUpdate((ZobristImages){ { 0 } }, 0, board);
+}
@@ -0,0 +1,66 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+#include "board.h"
+
+#define ZOBRIST_IMAGES 8
+
+// One random key per cell and exponent, XORed together for the occupied cells.
+// The keys come from a fixed seed, so hashes are stable across runs and machines.
+extern uint64_t zobristKeys[BOARD_CELLS][16];
+
+// The key each cell and exponent has in every rotation and reflection of the
+// board, side by side so updating all 8 images is a few vector XORs.
+extern uint64_t zobristImageKeys[BOARD_CELLS][16][ZOBRIST_IMAGES];
+
+// Fills the keys, called by boardInit().
+void zobristInit(void);
+
+uint64_t zobristHash(Board board);
+
+// Updates the hash of before to the hash of after, touching only changed cells.
+static inline uint64_t zobristUpdate(uint64_t hash, Board before, Board after) {
+	Board changed = before ^ after;
+	while (changed) {
+		int cell = __builtin_ctzll(changed) / 4;
+		hash ^= zobristKeys[cell][(before >> (4 * cell)) & 0xF] ^ zobristKeys[cell][(after >> (4 * cell)) & 0xF];
+		changed &= ~((Board)0xF << (4 * cell));
+	}
+	return hash;
+}
+
+// Hashes of the 8 symmetric images of a position.
+typedef struct {
+	uint64_t images[ZOBRIST_IMAGES];
+} ZobristImages;
+
+ZobristImages zobristImages(Board board);
+
+// zobristUpdate() for all 8 images at once.
+static inline ZobristImages zobristImagesUpdate(ZobristImages hashes, Board before, Board after) {
+	Board changed = before ^ after;
+	while (changed) {
+		int cell = __builtin_ctzll(changed) / 4;
+		const uint64_t *removed = zobristImageKeys[cell][(before >> (4 * cell)) & 0xF];
+		const uint64_t *added = zobristImageKeys[cell][(after >> (4 * cell)) & 0xF];
+		for (int i = 0; i < ZOBRIST_IMAGES; i++) {
+			hashes.images[i] ^= removed[i] ^ added[i];
+		}
+		changed &= ~((Board)0xF << (4 * cell));
+	}
+	return hashes;
+}
+
+// The smallest image hash. Symmetric positions have the same set of images, so
+// this is equal for all 8 of them, like boardCanonical().
+static inline uint64_t zobristCanonical(const ZobristImages *hashes) {
+	uint64_t best = hashes->images[0];
+	for (int i = 1; i < ZOBRIST_IMAGES; i++) {
+		if (hashes->images[i] < best) best = hashes->images[i];
+	}
+	return best;
+}
+
+#endif